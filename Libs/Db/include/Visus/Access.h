@@ -41,6 +41,7 @@ For support : support@visus.net
 
 #include <Visus/Db.h>
 #include <Visus/BlockQuery.h>
+#include <Visus/ThreadPool.h>
 
 namespace Visus {
 
@@ -154,6 +155,42 @@ public:
   //readBlock
   virtual void readBlock(SharedPtr<BlockQuery> query) = 0;
 
+  //readBlocks (override it if the access can do better than one request per block, for example coalescing adjacent reads)
+  virtual void readBlocks(std::vector< SharedPtr<BlockQuery> > queries) {
+    for (auto query : queries)
+      readBlock(query);
+  }
+
+  //getBlockPresence (if not null, a zero bit means that the block does not exist and there is no need to read it)
+  virtual SharedPtr< std::vector<bool> > getBlockPresence(Field field, double time) {
+    return SharedPtr< std::vector<bool> >();
+  }
+
+  //getBlockRanges (if valid, float64 array of dims (2*ncomponents, nblocks) with the min/max of each component of each block)
+  virtual Array getBlockRanges(Field field, double time) {
+    return Array();
+  }
+
+  //prefetchBlocks (hint: the blocks will be read soon and in this order, the access can start fetching them ahead of the reads)
+  virtual void prefetchBlocks(Field field, double time, const std::vector<BigInt>& blockids) {
+  }
+
+  //prefetchBlocks (same hint for the blocks of several fields and timesteps read in one pass, each one is (index in fields, time, blockid))
+  virtual void prefetchBlocks(const std::vector<Field>& fields, const std::vector< std::tuple<int, double, BigInt> >& blocks) 
+  {
+    std::map< std::pair<int, double>, std::vector<BigInt> > split;
+    for (const auto& it : blocks)
+      split[std::make_pair(std::get<0>(it), std::get<1>(it))].push_back(std::get<2>(it));
+
+    for (const auto& it : split)
+      prefetchBlocks(fields[it.first.first], it.first.second, it.second);
+  }
+
+  //getStoredBlockSizes (stored bytes of each block, only if known without reading any payload: -1 unknown, 0 missing or constant block)
+  virtual std::vector<Int64> getStoredBlockSizes(Field field, double time, const std::vector<BigInt>& blockids) {
+    return std::vector<Int64>(blockids.size(), -1);
+  }
+
   //writeBlock
   virtual void writeBlock(SharedPtr<BlockQuery> query) = 0;
 
@@ -177,6 +214,16 @@ public:
     endIO();
   }
 
+  //getWriteThreadPool (if not null, box queries in writing mode use it to merge blocks in parallel)
+  virtual SharedPtr<ThreadPool> getWriteThreadPool() {
+    return SharedPtr<ThreadPool>();
+  }
+
+  //getMergeThreadPool (if not null, box queries in reading mode use it to merge blocks in parallel)
+  virtual SharedPtr<ThreadPool> getMergeThreadPool() {
+    return SharedPtr<ThreadPool>();
+  }
+
   //in case you want first to read block, merge block samples, and finally write block you need a "lease" (using Microsoft Azure cloud terminology)
   virtual void acquireWriteLock(SharedPtr<BlockQuery> query) {
     VisusAssert(isWriting());
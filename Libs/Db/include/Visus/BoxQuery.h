@@ -47,6 +47,7 @@ namespace Visus {
 
 //predeclaration
 class IdxFilter;
+class IdxBoxQueryPlan;
 class Dataset;
 class Access;
 
@@ -96,6 +97,27 @@ public:
   filter;
 #endif
 
+  //value predicate (for idx, blocks with all samples of component outside [from,to] are not read, see IdxDataset::executeBoxQuery)
+#if !SWIG
+  struct
+  {
+    bool                     enabled = false;
+    int                      component = 0;
+    double                   from = 0;
+    double                   to = 0;
+    Int64                    npruned = 0; //output, number of blocks filled with the block min or max instead of the data
+  }
+  value_range;
+#endif
+
+  //for idx (blocks and copy spans, shared between queries with the same logic samples and resolutions, see IdxDataset::getBoxQueryPlan)
+#if !SWIG
+  SharedPtr<IdxBoxQueryPlan> plan;
+#endif
+
+  //for idx, reading: cap on the bytes of the blocks in flight (0 means no cap, see IdxBoxQueryStream)
+  Int64                      max_read_memory = 0;
+
   //for midx
 #if !SWIG
   struct
@@ -173,6 +195,53 @@ public:
     this->filter.enabled = true;
   }
 
+  //setValueRange (only samples in [from,to] are needed, the samples of the pruned blocks are replaced by the block min or max)
+  void setValueRange(double from, double to, int component = 0) {
+    this->value_range.enabled = true;
+    this->value_range.component = component;
+    this->value_range.from = from;
+    this->value_range.to = to;
+  }
+
+  //setIsoValue (only blocks intersecting the isovalue are needed)
+  void setIsoValue(double value, int component = 0) {
+    setValueRange(value, value, component);
+  }
+
+  //disableValueRange
+  void disableValueRange() {
+    this->value_range.enabled = false;
+  }
+
+  //hasFillValues (true if some samples of the buffer are not data, but the min or max of a pruned block, see setValueRange)
+  bool hasFillValues() const {
+    return this->value_range.npruned > 0;
+  }
+
+};
+
+
+////////////////////////////////////////////////////////
+//estimated cost of a box query for one end resolution (see Dataset::estimateBoxQueryCost)
+class VISUS_DB_API BoxQueryCost
+{
+public:
+
+  int     end_resolution = -1;
+  PointNi nsamples;              //output samples
+  Int64   output_bytes = 0;      //output buffer size
+  Int64   nblocks = 0;           //blocks to read (blocks known to be missing are not counted)
+  Int64   nblocks_known = 0;     //blocks whose stored size is known without any I/O
+  Int64   decoded_bytes = 0;     //decoded size of the blocks
+  Int64   compressed_bytes = 0;  //stored size of the blocks (extrapolated from the known ones, or decoded_bytes if none is known)
+
+  //constructor
+  BoxQueryCost() {
+  }
+
+  //write
+  void write(Archive& ar) const;
+
 };
 
 
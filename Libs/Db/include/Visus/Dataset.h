@@ -349,10 +349,14 @@ public:
   //readBlock  
   virtual void executeBlockQuery(SharedPtr<Access> access, SharedPtr<BlockQuery> query);
 
+  //executeBlockQuery (read only, the access receives all queries at once so it can reorder/coalesce them)
+  virtual void executeBlockQuery(SharedPtr<Access> access, std::vector< SharedPtr<BlockQuery> > queries);
+
   //executeBlockQueryAndWait
   bool executeBlockQueryAndWait(SharedPtr<Access> access, SharedPtr<BlockQuery> query) {
     executeBlockQuery(access, query);
-    query->done.get(); 
+    if (!query->done.wait(query->aborted))
+      return false;
     return query->ok();
   }
 
@@ -377,6 +381,11 @@ public:
   //guessBoxQueryEndResolutions
   virtual std::vector<int> guessBoxQueryEndResolutions(Frustum logic_to_screen, Position logic_position, int quality, int progression);
 
+  //estimateBoxQueryCost (one entry for each end resolution of the query, or for all of them if not specified; no payload is read)
+  virtual std::vector<BoxQueryCost> estimateBoxQueryCost(SharedPtr<BoxQuery> query, SharedPtr<Access> access = SharedPtr<Access>()) {
+    return std::vector<BoxQueryCost>();
+  }
+
   //beginBoxQuery
   virtual void beginBoxQuery(SharedPtr<BoxQuery> query) {
     ThrowException("not implemented");
@@ -42,6 +42,7 @@ For support : support@visus.net
 #include <Visus/Db.h>
 #include <Visus/Access.h>
 #include <Visus/Path.h>
+#include <Visus/File.h>
 
 namespace Visus {
 
@@ -58,8 +59,7 @@ public:
   DiskAccess(Dataset* dataset, StringTree config = StringTree());
 
   //destructor 
-  virtual ~DiskAccess() {
-  }
+  virtual ~DiskAccess();
 
   //readBlock
   virtual void readBlock(SharedPtr<BlockQuery> query) override;
@@ -67,6 +67,9 @@ public:
   //writeBlock
   virtual void writeBlock(SharedPtr<BlockQuery> query) override;
 
+  //endIO
+  virtual void endIO() override;
+
   //acquireWriteLock
   virtual void acquireWriteLock(SharedPtr<BlockQuery> query) override;
 
@@ -82,6 +85,23 @@ private:
   String              compression;
   String              filename_template;
 
+  //shard mode: 2^shard_bits consecutive blocks are packed in one file with an offset index in front (0 means one file for each block)
+  int                 shard_bits = 0;
+  File                shard;
+
+  //bounded cache (config available>0): whole files are evicted, least recently (eviction="lru") or least frequently (eviction="lfu") used first
+  class Usage;
+  UniquePtr<Usage>    usage;
+
+  //openShard (the last shard is kept open)
+  bool openShard(String filename, String file_mode);
+
+  //readShardBlock
+  SharedPtr<HeapMemory> readShardBlock(String filename, BigInt blockid);
+
+  //writeShardBlock
+  bool writeShardBlock(String filename, BigInt blockid, SharedPtr<HeapMemory> encoded);
+
 }; 
 
 } //namespace Visus
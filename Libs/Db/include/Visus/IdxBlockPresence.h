@@ -0,0 +1,99 @@
+/*-----------------------------------------------------------------------------
+Copyright(c) 2010 - 2018 ViSUS L.L.C.,
+Scientific Computing and Imaging Institute of the University of Utah
+
+ViSUS L.L.C., 50 W.Broadway, Ste. 300, 84101 - 2044 Salt Lake City, UT
+University of Utah, 72 S Central Campus Dr, Room 3750, 84112 Salt Lake City, UT
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met :
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+For additional information about this project contact : pascucci@acm.org
+For support : support@visus.net
+-----------------------------------------------------------------------------*/
+
+#ifndef __VISUS_IDX_BLOCK_PRESENCE_H
+#define __VISUS_IDX_BLOCK_PRESENCE_H
+
+#include <Visus/Db.h>
+#include <Visus/IdxBlockSidecar.h>
+
+namespace Visus {
+
+/////////////////////////////////////////////////////////////////////////////
+/*
+Sidecar file (stored next to the idx file) telling, for each field and timestep, which blocks have been written.
+
+A bitmap is either complete (every written block has its bit set) or missing, so a zero bit always means
+the block does not exist. Writers mark the bitmap as "being written" on disk before writing any new block
+and merge their bits when they are done, so the readers never skip blocks that are being written
+(see IdxBlockSidecar).
+*/
+class VISUS_DB_API IdxBlockPresence : public IdxBlockSidecar< SharedPtr< std::vector<bool> >, std::vector<BigInt> >
+{
+public:
+
+  VISUS_NON_COPYABLE_CLASS(IdxBlockPresence)
+
+  typedef std::vector<bool> Bitmap;
+
+  //constructor
+  IdxBlockPresence(String filename) : IdxBlockSidecar("presence", "bitmap", filename) {
+  }
+
+  //getDefaultFilename
+  static String getDefaultFilename(String idx_filename) {
+    return idx_filename + ".presence";
+  }
+
+  //getBitmap (null if unknown or, unless bEvenIfWriting, if someone is writing the blocks)
+  SharedPtr<Bitmap> getBitmap(String field, double time, bool bEvenIfWriting = false) const {
+    return getValue(field, time, bEvenIfWriting);
+  }
+
+  //setBitmap
+  void setBitmap(String field, double time, SharedPtr<Bitmap> value) {
+    setValue(field, time, value);
+  }
+
+protected:
+
+  //readValue
+  virtual SharedPtr<Bitmap> readValue(const StringTree& child) const override;
+
+  //writeValue
+  virtual bool writeValue(StringTree& child, const SharedPtr<Bitmap>& value) const override;
+
+  //applyUpdates
+  virtual SharedPtr<Bitmap> applyUpdates(const SharedPtr<Bitmap>& value, const std::vector<BigInt>& blockids) const override;
+
+};
+
+} //namespace Visus
+
+#endif //__VISUS_IDX_BLOCK_PRESENCE_H
+
@@ -0,0 +1,106 @@
+/*-----------------------------------------------------------------------------
+Copyright(c) 2010 - 2018 ViSUS L.L.C.,
+Scientific Computing and Imaging Institute of the University of Utah
+
+ViSUS L.L.C., 50 W.Broadway, Ste. 300, 84101 - 2044 Salt Lake City, UT
+University of Utah, 72 S Central Campus Dr, Room 3750, 84112 Salt Lake City, UT
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met :
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+For additional information about this project contact : pascucci@acm.org
+For support : support@visus.net
+-----------------------------------------------------------------------------*/
+
+#ifndef __VISUS_IDX_BLOCK_RANGES_H
+#define __VISUS_IDX_BLOCK_RANGES_H
+
+#include <Visus/Db.h>
+#include <Visus/Array.h>
+#include <Visus/IdxBlockSidecar.h>
+
+namespace Visus {
+
+/////////////////////////////////////////////////////////////////////////////
+/*
+Sidecar file (stored next to the idx file) with the min/max of each component of each block, for each field and timestep.
+
+Ranges are a float64 array of dims (2*ncomponents, nblocks), blocks never written have min>max.
+Like IdxBlockPresence, writers mark the ranges as "being written" on disk before writing any block and merge 
+their values when they are done, so the readers never prune blocks using old ranges (see IdxBlockSidecar).
+*/
+class VISUS_DB_API IdxBlockRanges : public IdxBlockSidecar< Array, std::map<BigInt, std::vector<double> > >
+{
+public:
+
+  VISUS_NON_COPYABLE_CLASS(IdxBlockRanges)
+
+  //constructor
+  IdxBlockRanges(String filename) : IdxBlockSidecar("ranges", "ranges", filename) {
+  }
+
+  //getDefaultFilename
+  static String getDefaultFilename(String idx_filename) {
+    return idx_filename + ".ranges";
+  }
+
+  //createRanges (all blocks with an empty range)
+  static Array createRanges(int ncomponents, Int64 nblocks);
+
+  //computeRanges (min and max of each component, in the same order of a ranges row)
+  static std::vector<double> computeRanges(Array block);
+
+  //unknownRanges (a ranges row for a block that must never be pruned)
+  static std::vector<double> unknownRanges(int ncomponents);
+
+  //getRanges (invalid if unknown or, unless bEvenIfWriting, if someone is writing the blocks)
+  Array getRanges(String field, double time, bool bEvenIfWriting = false) const {
+    return getValue(field, time, bEvenIfWriting);
+  }
+
+  //setRanges
+  void setRanges(String field, double time, Array value) {
+    setValue(field, time, value);
+  }
+
+protected:
+
+  //readValue
+  virtual Array readValue(const StringTree& child) const override;
+
+  //writeValue
+  virtual bool writeValue(StringTree& child, const Array& value) const override;
+
+  //applyUpdates
+  virtual Array applyUpdates(const Array& value, const std::map<BigInt, std::vector<double> >& values) const override;
+
+};
+
+} //namespace Visus
+
+#endif //__VISUS_IDX_BLOCK_RANGES_H
+
@@ -0,0 +1,331 @@
+/*-----------------------------------------------------------------------------
+Copyright(c) 2010 - 2018 ViSUS L.L.C.,
+Scientific Computing and Imaging Institute of the University of Utah
+
+ViSUS L.L.C., 50 W.Broadway, Ste. 300, 84101 - 2044 Salt Lake City, UT
+University of Utah, 72 S Central Campus Dr, Room 3750, 84112 Salt Lake City, UT
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met :
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+For additional information about this project contact : pascucci@acm.org
+For support : support@visus.net
+-----------------------------------------------------------------------------*/
+
+#ifndef __VISUS_IDX_BLOCK_SIDECAR_H
+#define __VISUS_IDX_BLOCK_SIDECAR_H
+
+#include <Visus/Db.h>
+#include <Visus/StringTree.h>
+#include <Visus/File.h>
+#include <Visus/Utils.h>
+#include <Visus/Time.h>
+
+#include <map>
+
+namespace Visus {
+
+/////////////////////////////////////////////////////////////////////////////
+/*
+Sidecar file (stored next to the idx file) with one value for each field and timestep (see IdxBlockPresence and IdxBlockRanges).
+
+Writers mark the value as "being written" on disk before writing any block and merge their updates when they are done,
+so readers never use a value that is not up to date. A crashed writer leaves the value unknown until the next scan 
+(readers log it, with the time of the last beginUpdate).
+
+Values are decoded only when used, and the ones not used are saved back as they were read.
+*/
+template <typename Value, typename Updates>
+class IdxBlockSidecar
+{
+public:
+
+  VISUS_NON_COPYABLE_CLASS(IdxBlockSidecar)
+
+  //constructor
+  IdxBlockSidecar(String doc_name_, String child_name_, String filename_) 
+    : doc_name(doc_name_), child_name(child_name_), filename(filename_) {
+  }
+
+  //destructor
+  virtual ~IdxBlockSidecar() {
+  }
+
+  //getFilename
+  String getFilename() const {
+    return filename;
+  }
+
+  //load (false if the file does not exist or it's not valid)
+  bool load();
+
+  //needReload (true if never loaded; modification time has a resolution of one second, so a file modified too recently is always reloaded)
+  bool needReload() const;
+
+  //save
+  bool save();
+
+  //beginUpdate (on disk)
+  bool beginUpdate(String field, double time);
+
+  //endUpdate (on disk)
+  bool endUpdate(String field, double time, const Updates& updates);
+
+protected:
+
+  //readValue
+  virtual Value readValue(const StringTree& child) const = 0;
+
+  //writeValue
+  virtual bool writeValue(StringTree& child, const Value& value) const = 0;
+
+  //applyUpdates (must return a copy, someone else could be using the old value)
+  virtual Value applyUpdates(const Value& value, const Updates& updates) const = 0;
+
+  //getValue (null if unknown or, unless bEvenIfWriting, if someone is writing the blocks)
+  Value getValue(String field, double time, bool bEvenIfWriting) const;
+
+  //setValue
+  void setValue(String field, double time, Value value);
+
+private:
+
+  //_______________________________________________
+  class Entry
+  {
+  public:
+    mutable Value                     value;
+    mutable SharedPtr<StringTree>     encoded;
+    int                               writers = 0;
+    Int64                             writer_time = 0;
+    mutable bool                      bLogged = false;
+  };
+
+  String                                        doc_name;
+  String                                        child_name;
+  String                                        filename;
+  bool                                          bLoaded = false;
+  Int64                                         mtime = 0;
+  Time                                          load_time;
+  std::map< std::pair<String, double>, Entry >  entries;
+
+  //decode (false if the value is not valid)
+  bool decode(const Entry& entry) const;
+
+};
+
+/////////////////////////////////////////////////////////////////////////////
+template <typename Value, typename Updates>
+inline bool IdxBlockSidecar<Value, Updates>::load()
+{
+  entries.clear();
+
+  this->bLoaded = true;
+  this->load_time = Time::now();
+  this->mtime = FileUtils::getTimeLastModified(filename);
+  if (!FileUtils::existsFile(filename))
+    return false;
+
+  auto doc = StringTree::fromString(Utils::loadTextDocument(filename));
+  if (doc.name != doc_name)
+    return false;
+
+  for (auto it : doc.getChilds(child_name))
+  {
+    Entry entry;
+    entry.writers = it->readInt("writers", 0);
+    entry.writer_time = it->readInt64("writer_time", 0);
+    entry.encoded = it;
+    entries[std::make_pair(it->readString("field"), it->readDouble("time"))] = entry;
+  }
+
+  return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+template <typename Value, typename Updates>
+inline bool IdxBlockSidecar<Value, Updates>::needReload() const
+{
+  if (!bLoaded)
+    return true;
+
+  auto value = FileUtils::getTimeLastModified(filename);
+  return value != this->mtime || (load_time.getUTCMilliseconds() / 1000 - value) <= 1;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+template <typename Value, typename Updates>
+inline bool IdxBlockSidecar<Value, Updates>::decode(const Entry& entry) const
+{
+  if (!entry.encoded)
+    return (bool)entry.value;
+
+  //a wrong value is dropped (and not saved back)
+  entry.value = readValue(*entry.encoded);
+  entry.encoded.reset();
+  if (!entry.value)
+  {
+    PrintInfo("IdxBlockSidecar wrong", child_name, "in", filename);
+    return false;
+  }
+
+  return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+template <typename Value, typename Updates>
+inline bool IdxBlockSidecar<Value, Updates>::save()
+{
+  StringTree doc(doc_name);
+  doc.write("version", 1);
+  for (const auto& it : entries)
+  {
+    //never decoded, save it back as it is
+    if (auto encoded = it.second.encoded)
+    {
+      encoded->write("writers", it.second.writers);
+      encoded->write("writer_time", it.second.writer_time);
+      doc.addChild(encoded);
+      continue;
+    }
+
+    if (!it.second.value)
+      continue;
+
+    auto child = doc.addChild(child_name);
+    child->write("field", it.first.first);
+    child->write("time", it.first.second);
+    child->write("writers", it.second.writers);
+    child->write("writer_time", it.second.writer_time);
+    if (!writeValue(*child, it.second.value))
+      return false;
+  }
+
+  //readers must never see a partial file
+  String tmp_filename = filename + ".tmp";
+  try
+  {
+    Utils::saveTextDocument(tmp_filename, doc.toString());
+  }
+  catch (...)
+  {
+    FileUtils::removeFile(tmp_filename);
+    return false;
+  }
+
+  if (!FileUtils::moveFile(tmp_filename, filename))
+  {
+    //windows cannot rename over an existing file
+    FileUtils::removeFile(filename);
+    if (!FileUtils::moveFile(tmp_filename, filename))
+      return false;
+  }
+
+  return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+template <typename Value, typename Updates>
+inline Value IdxBlockSidecar<Value, Updates>::getValue(String field, double time, bool bEvenIfWriting) const
+{
+  auto it = entries.find(std::make_pair(field, time));
+  if (it == entries.end())
+    return Value();
+
+  const auto& entry = it->second;
+  if (!decode(entry))
+    return Value();
+
+  if (entry.writers > 0 && !bEvenIfWriting)
+  {
+    if (!entry.bLogged)
+    {
+      entry.bLogged = true;
+      PrintInfo("IdxBlockSidecar", filename, "field", field, "time", time, "ignored, there are", entry.writers, "writers",
+        "last one started", (Time::now().getUTCMilliseconds() - entry.writer_time) / 1000, "seconds ago (if it crashed a scan is needed)");
+    }
+    return Value();
+  }
+
+  return entry.value;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+template <typename Value, typename Updates>
+inline void IdxBlockSidecar<Value, Updates>::setValue(String field, double time, Value value)
+{
+  auto& entry = entries[std::make_pair(field, time)];
+  entry.value = value;
+  entry.encoded.reset();
+  entry.writers = 0;
+  entry.writer_time = 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+template <typename Value, typename Updates>
+inline bool IdxBlockSidecar<Value, Updates>::beginUpdate(String field, double time)
+{
+  FileUtils::lock(filename);
+  load();
+
+  bool ret = false;
+  auto it = entries.find(std::make_pair(field, time));
+  if (it != entries.end())
+  {
+    it->second.writers++;
+    it->second.writer_time = Time::now().getUTCMilliseconds();
+    ret = save();
+  }
+
+  FileUtils::unlock(filename);
+  return ret;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+template <typename Value, typename Updates>
+inline bool IdxBlockSidecar<Value, Updates>::endUpdate(String field, double time, const Updates& updates)
+{
+  FileUtils::lock(filename);
+  load();
+
+  bool ret = false;
+  auto it = entries.find(std::make_pair(field, time));
+  if (it != entries.end() && it->second.writers > 0 && decode(it->second))
+  {
+    it->second.value = applyUpdates(it->second.value, updates);
+    it->second.writers--;
+    ret = save();
+  }
+
+  FileUtils::unlock(filename);
+  return ret;
+}
+
+} //namespace Visus
+
+#endif //__VISUS_IDX_BLOCK_SIDECAR_H
+
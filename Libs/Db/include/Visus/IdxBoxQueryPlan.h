@@ -0,0 +1,215 @@
+/*-----------------------------------------------------------------------------
+Copyright(c) 2010 - 2018 ViSUS L.L.C.,
+Scientific Computing and Imaging Institute of the University of Utah
+
+ViSUS L.L.C., 50 W.Broadway, Ste. 300, 84101 - 2044 Salt Lake City, UT
+University of Utah, 72 S Central Campus Dr, Room 3750, 84112 Salt Lake City, UT
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met :
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+For additional information about this project contact : pascucci@acm.org
+For support : support@visus.net
+-----------------------------------------------------------------------------*/
+
+
+#ifndef __VISUS_IDX_BOX_QUERY_PLAN_H
+#define __VISUS_IDX_BOX_QUERY_PLAN_H
+
+#include <Visus/Db.h>
+#include <Visus/LogicSamples.h>
+#include <Visus/CriticalSection.h>
+
+#include <list>
+#include <map>
+
+namespace Visus {
+
+class IdxBoxQueryPlanCache;
+
+/////////////////////////////////////////////////////////////////////////////
+/*
+What a box query needs from the HZ traversal: the blocks it intersects and, for each block, the runs of block samples 
+to copy into the query buffer. It depends only on the bitmask, the aligned logic samples, the resolution range 
+and bitsperblock, so the same plan serves all fields and timesteps.
+
+Blocks are computed when the plan is created, copy spans are recorded the first time each block is merged.
+Scatter offsets (one small table for each level) are computed the first time a level is merged.
+Once the plan is in IdxBoxQueryPlanCache, what it records is charged to the cache.
+*/
+class VISUS_DB_API IdxBoxQueryPlan
+{
+public:
+
+  VISUS_NON_COPYABLE_CLASS(IdxBoxQueryPlan)
+
+  //block samples [hzfrom,hzfrom+num) go to the query samples starting at from, following the level H address deltas
+  struct Span
+  {
+    Int64 hzfrom;
+    Int64 from;
+    Int64 num;
+    int   H;
+  };
+
+  String               key;
+  BoxNi                logic_box;
+  PointNi              delta;
+  int                  cur_resolution = -1;
+  int                  end_resolution = -1;
+  int                  bitsperblock = 0;
+  std::vector<BigInt>  blocks;
+
+  //spans are recorded up to this limit while the plan is not in the cache (0 by default, nobody would reuse them)
+  const Int64          max_memory;
+
+  //constructor
+  IdxBoxQueryPlan(Int64 max_memory_ = 0) : max_memory(std::max((Int64)0, max_memory_)), cache(nullptr) {
+  }
+
+  //getKey
+  static String getKey(String bitmask, const LogicSamples& logic_samples, int cur_resolution, int end_resolution, int bitsperblock);
+
+  //matches (i.e. the query is still in the state the plan was created for)
+  bool matches(const LogicSamples& logic_samples, int cur_resolution, int end_resolution, int bitsperblock) const {
+    return this->logic_box == logic_samples.logic_box && this->delta == logic_samples.delta &&
+      this->cur_resolution == cur_resolution && this->end_resolution == end_resolution && this->bitsperblock == bitsperblock;
+  }
+
+  //getSpans (null if not recorded yet)
+  SharedPtr< std::vector<Span> > getSpans(BigInt blockid);
+
+  //setSpans
+  void setSpans(BigInt blockid, SharedPtr< std::vector<Span> > value);
+
+  //getScatterOffsets (query buffer offsets of the samples of a level H span, relative to its first sample; null if not computed yet)
+  SharedPtr< std::vector<Int32> > getScatterOffsets(int H);
+
+  //setScatterOffsets
+  void setScatterOffsets(int H, SharedPtr< std::vector<Int32> > value);
+
+  //getMemSize
+  Int64 getMemSize() const;
+
+private:
+
+  friend class IdxBoxQueryPlanCache;
+
+  CriticalSection                                   lock;
+  std::atomic<IdxBoxQueryPlanCache*>                cache;
+  Int64                                             spans_memsize = 0;
+  std::map<BigInt, SharedPtr< std::vector<Span> > > spans;
+  std::map<int, SharedPtr< std::vector<Int32> > >   offsets;
+
+};
+
+
+//////////////////////////////////////////////////////////////////////////////
+class VISUS_DB_API IdxBoxQueryPlanCache
+{
+public:
+
+  VISUS_DECLARE_SINGLETON_CLASS(IdxBoxQueryPlanCache)
+
+#if !SWIG
+  std::atomic<Int64> nhit;
+  std::atomic<Int64> nmiss;
+#endif
+
+  //getMaxMemory
+  Int64 getMaxMemory() const {
+    return max_memory;
+  }
+
+  //setMaxMemory (0 disables the cache)
+  void setMaxMemory(Int64 value);
+
+  //getUsedMemory (includes what the cached plans recorded after put)
+  Int64 getUsedMemory() const;
+
+  //getNumHit
+  Int64 getNumHit() const {
+    return nhit;
+  }
+
+  //getNumMiss
+  Int64 getNumMiss() const {
+    return nmiss;
+  }
+
+  //get
+  SharedPtr<IdxBoxQueryPlan> get(String key);
+
+  //peek (like get, but does not touch the hit/miss stats and the LRU order)
+  SharedPtr<IdxBoxQueryPlan> peek(String key) const;
+
+  //put (call it before sharing the plan, it grows at the expense of the cache from now on)
+  void put(SharedPtr<IdxBoxQueryPlan> plan);
+
+  //clear
+  void clear();
+
+private:
+
+  friend class IdxBoxQueryPlan;
+
+  //_______________________________________________
+  class Cached
+  {
+  public:
+    SharedPtr<IdxBoxQueryPlan>       plan;
+    Int64                            memsize = 0;
+    std::list<String>::iterator      lru;
+  };
+
+  CriticalSection                    lock;
+  Int64                              max_memory = 64 * 1024 * 1024;
+  Int64                              used_memory = 0;
+  std::list<String>                  lru;
+  std::map<String, Cached>           index;
+
+  //constructor
+  IdxBoxQueryPlanCache() : nhit(0), nmiss(0) {
+  }
+
+  //destructor
+  ~IdxBoxQueryPlanCache() {
+    clear();
+  }
+
+  //charge (a cached plan is about to grow by memsize, false if the plan is not in the cache anymore or there is no room)
+  bool charge(IdxBoxQueryPlan* plan, Int64 memsize);
+
+  //remove (must have the lock)
+  void remove(std::map<String, Cached>::iterator it);
+
+};
+
+} //namespace Visus
+
+#endif //__VISUS_IDX_BOX_QUERY_PLAN_H
+
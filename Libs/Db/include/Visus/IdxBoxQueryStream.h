@@ -0,0 +1,148 @@
+/*-----------------------------------------------------------------------------
+Copyright(c) 2010 - 2018 ViSUS L.L.C.,
+Scientific Computing and Imaging Institute of the University of Utah
+
+ViSUS L.L.C., 50 W.Broadway, Ste. 300, 84101 - 2044 Salt Lake City, UT
+University of Utah, 72 S Central Campus Dr, Room 3750, 84112 Salt Lake City, UT
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met :
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+For additional information about this project contact : pascucci@acm.org
+For support : support@visus.net
+-----------------------------------------------------------------------------*/
+
+#ifndef __VISUS_IDX_BOX_QUERY_STREAM_H
+#define __VISUS_IDX_BOX_QUERY_STREAM_H
+
+#include <Visus/Db.h>
+#include <Visus/BoxQuery.h>
+
+namespace Visus {
+
+//predeclaration
+class IdxDataset;
+class Access;
+
+/////////////////////////////////////////////////////////////////////////////
+/*
+Streaming read of a box query too big to be allocated in one piece: the query region is read tile by tile,
+each tile is an ordinary box query with the same field, time and end resolution.
+
+Tiles have power of 2 sizes (in samples) and are aligned to a global grid, so they do not split blocks that are
+smaller than a tile. Before the caller consumes a tile, the blocks of the next tile are announced to the access;
+this is only a hint (see Access::prefetchBlocks), e.g. IdxDiskAccess starts fetching them only if readahead is enabled.
+Only one tile buffer is allocated at a time; tiles are shrunk so that a tile takes at most half of max_memory,
+the other half is for the blocks in flight (see BoxQuery::max_read_memory).
+
+Filters are not supported (they need the samples outside the tile), the query must have them disabled.
+
+  IdxBoxQueryStream stream(dataset, access, query, PointNi(512, 512, 64));
+  while (stream.next())
+    consume(stream.getLogicBox(), stream.getBuffer());
+*/
+class VISUS_DB_API IdxBoxQueryStream
+{
+public:
+
+  VISUS_NON_COPYABLE_CLASS(IdxBoxQueryStream)
+
+  //Defaults
+  class VISUS_DB_API Defaults
+  {
+  public:
+    static Int64 max_memory;
+  };
+
+  //constructor (query must be a running read query; an empty tile_size means as big as the budget allows; max_memory<=0 means Defaults::max_memory)
+  IdxBoxQueryStream(IdxDataset* dataset, SharedPtr<Access> access, SharedPtr<BoxQuery> query, PointNi tile_size = PointNi(), Int64 max_memory = 0);
+
+  //destructor
+  virtual ~IdxBoxQueryStream();
+
+  //getQuery
+  SharedPtr<BoxQuery> getQuery() const {
+    return query;
+  }
+
+  //getTileSize (in samples)
+  PointNi getTileSize() const {
+    return tile_size;
+  }
+
+  //getMaxMemory
+  Int64 getMaxMemory() const {
+    return max_memory;
+  }
+
+  //getNumberOfTiles
+  Int64 getNumberOfTiles() const {
+    return ntiles.innerProduct();
+  }
+
+  //getTileLogicBox
+  BoxNi getTileLogicBox(Int64 I) const;
+
+  //next (reads the next tile, false if there are no more tiles or the query failed)
+  bool next();
+
+  //getLogicBox (of the last tile read)
+  BoxNi getLogicBox() const {
+    return current ? current->logic_samples.logic_box : BoxNi();
+  }
+
+  //getBuffer (of the last tile read)
+  Array getBuffer() const {
+    return current ? current->buffer : Array();
+  }
+
+private:
+
+  IdxDataset*          dataset = nullptr;
+  SharedPtr<Access>    access;
+  SharedPtr<BoxQuery>  query;
+  Int64                max_memory = 0;
+  LogicSamples         logic_samples;
+  PointNi              tile_size;
+  PointNi              first;
+  PointNi              ntiles;
+  Int64                cursor = 0;
+  SharedPtr<BoxQuery>  current;
+  SharedPtr<BoxQuery>  prefetched;
+
+  //createTileQuery (null if failed)
+  SharedPtr<BoxQuery> createTileQuery(Int64 I);
+
+  //prefetch (advisory, see Access::prefetchBlocks)
+  void prefetch(SharedPtr<BoxQuery> tile);
+
+};
+
+} //namespace Visus
+
+#endif //__VISUS_IDX_BOX_QUERY_STREAM_H
+
@@ -43,12 +43,38 @@ For support : support@visus.net
 #include <Visus/Dataset.h>
 #include <Visus/IdxFile.h>
 #include <Visus/IdxHzOrder.h>
+#include <Visus/IdxBoxQueryPlan.h>
 
 namespace Visus {
 
 #if !SWIG
 class IdxBoxQueryHzAddressConversion;
 class IdxPointQueryHzAddressConversion;
+
+//////////////////////////////////////////////////////////////////////
+//threads converting the points of big point queries to HZ addresses (allocated by DbModule::attach, released by DbModule::detach)
+class VISUS_DB_API IdxPointQueryThreadPool
+{
+public:
+
+  VISUS_DECLARE_SINGLETON_CLASS(IdxPointQueryThreadPool)
+
+  //get
+  SharedPtr<ThreadPool> get() const {
+    return tpool;
+  }
+
+  //destructor
+  ~IdxPointQueryThreadPool();
+
+private:
+
+  SharedPtr<ThreadPool> tpool;
+
+  //constructor
+  IdxPointQueryThreadPool();
+
+};
 #endif
 
 
@@ -103,6 +129,20 @@ public:
   //executeBoxQuery
   virtual bool executeBoxQuery(SharedPtr<Access> access,SharedPtr<BoxQuery> query) override;
 
+  //executeBoxQuery (read only, for several fields and/or timesteps of the same box in one pass; returns one array for each (time,field), time-major)
+  std::vector<Array> executeBoxQuery(SharedPtr<Access> access, SharedPtr<BoxQuery> query, std::vector<Field> fields, std::vector<double> timesteps);
+
+  //estimateBoxQueryCost (each end resolution is estimated as if read from scratch; compressed sizes come from access->getStoredBlockSizes)
+  virtual std::vector<BoxQueryCost> estimateBoxQueryCost(SharedPtr<BoxQuery> query, SharedPtr<Access> access = SharedPtr<Access>()) override;
+
+  //executeBoxQueries (several queries in one pass: the blocks needed by more than one read query are read and decoded only once; false if any query failed)
+  bool executeBoxQueries(SharedPtr<Access> access, std::vector< SharedPtr<BoxQuery> > queries);
+
+#if !SWIG
+  //streamBoxQuery (read only, in bounded memory: the region is read tile by tile and each tile is passed to the callback, which can return false to stop; see IdxBoxQueryStream)
+  bool streamBoxQuery(SharedPtr<Access> access, SharedPtr<BoxQuery> query, PointNi tile_size, std::function<bool(BoxNi, Array)> callback, Int64 max_memory = 0);
+#endif
+
   //createBoxQueryRequest
   virtual NetRequest createBoxQueryRequest(SharedPtr<BoxQuery> query) override;
 
@@ -115,6 +155,15 @@ public:
   //adjustBoxQueryFilterBox
   BoxNi adjustBoxQueryFilterBox(BoxQuery* query, IdxFilter* filter, BoxNi box, int H);
 
+  //collectBoxQueryBlocks (blocks intersecting the query, in hz order, from the current resolution to the end resolution)
+  std::vector<BigInt> collectBoxQueryBlocks(BoxQuery* query, int bitsperblock);
+
+  //createBoxQueryPlan (not cached, records spans up to max_memory, null if aborted)
+  SharedPtr<IdxBoxQueryPlan> createBoxQueryPlan(BoxQuery* query, int bitsperblock, Int64 max_memory = 0);
+
+  //getBoxQueryPlan (from IdxBoxQueryPlanCache if possible, null if aborted)
+  SharedPtr<IdxBoxQueryPlan> getBoxQueryPlan(BoxQuery* query, int bitsperblock);
+
 public:
 
   //constructor
@@ -138,8 +187,8 @@ public:
 
 public:
 
-  //compressDataset
-  void compressDataset(std::vector<String> compression, Array data=Array());
+  //compressDataset (nthreads>0 compresses nthreads files at a time)
+  void compressDataset(std::vector<String> compression, Array data=Array(), int nthreads=0);
 
 public:
 
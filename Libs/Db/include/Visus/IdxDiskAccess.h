@@ -44,6 +44,10 @@ For support : support@visus.net
 #include <Visus/Access.h>
 #include <Visus/IdxFile.h>
 #include <Visus/File.h>
+#include <Visus/IdxBlockPresence.h>
+#include <Visus/IdxBlockRanges.h>
+
+#include <list>
 
 namespace Visus {
 
@@ -51,6 +55,82 @@ namespace Visus {
 class IdxDataset;
 
 
+//////////////////////////////////////////////////////////////////////////////
+class VISUS_DB_API IdxDiskAccessHeaderCache
+{
+public:
+
+  VISUS_DECLARE_SINGLETON_CLASS(IdxDiskAccessHeaderCache)
+
+#if !SWIG
+  std::atomic<Int64> nhit;
+  std::atomic<Int64> nmiss;
+#endif
+
+  //getMaxMemory
+  Int64 getMaxMemory() const {
+    return max_memory;
+  }
+
+  //setMaxMemory (0 disables the cache)
+  void setMaxMemory(Int64 value);
+
+  //getUsedMemory
+  Int64 getUsedMemory() const;
+
+  //getNumHit
+  Int64 getNumHit() const {
+    return nhit;
+  }
+
+  //getNumMiss
+  Int64 getNumMiss() const {
+    return nmiss;
+  }
+
+  //get (headers are in host byte order, returns null if not cached or if the file changed on disk, see FileUtils::getFileVersion)
+  SharedPtr<HeapMemory> get(String filename, String version);
+
+  //peek (like get, but does not touch the hit/miss stats and the LRU order)
+  SharedPtr<HeapMemory> peek(String filename, String version) const;
+
+  //put
+  void put(String filename, String version, SharedPtr<HeapMemory> headers);
+
+  //invalidate
+  void invalidate(String filename);
+
+  //clear
+  void clear();
+
+private:
+
+  //_______________________________________________
+  class Cached
+  {
+  public:
+    String                           version;
+    SharedPtr<HeapMemory>            headers;
+    std::list<String>::iterator      lru;
+  };
+
+  CriticalSection                    lock;
+  Int64                              max_memory = 64 * 1024 * 1024;
+  Int64                              used_memory = 0;
+  std::list<String>                  lru;
+  std::map<String, Cached>           index;
+
+  //constructor
+  IdxDiskAccessHeaderCache() : nhit(0), nmiss(0) {
+  }
+
+  //remove (must have the lock)
+  void remove(std::map<String, Cached>::iterator it);
+
+};
+
+
+
 //////////////////////////////////////////////////////////////////////////////
 class VISUS_DB_API IdxDiskAccess : public Access
 {
@@ -78,6 +158,17 @@ public:
   //disableWriteLock
   void disableWriteLock();
 
+  //enableDirectIO (V6 only, for full scans: reads bypass the page cache and written blocks are dropped from it, see direct_io)
+  void enableDirectIO(bool value = true);
+
+  //deferBlockSidecarUpdates (endWrite keeps the sidecar updates until flushBlockSidecarUpdates, for many short writes e.g. compressDataset)
+  void deferBlockSidecarUpdates(bool value = true) {
+    this->bDeferSidecarUpdates = value;
+  }
+
+  //flushBlockSidecarUpdates (all the written blocks must be on disk)
+  void flushBlockSidecarUpdates();
+
   //getFilename
   virtual String getFilename(Field field, double time, BigInt blockid) const override;
 
@@ -87,6 +178,30 @@ public:
   //readBlock 
   virtual void readBlock(SharedPtr<BlockQuery> query) override;
 
+  //readBlocks
+  virtual void readBlocks(std::vector< SharedPtr<BlockQuery> > queries) override;
+
+  //getBlockPresence
+  virtual SharedPtr< std::vector<bool> > getBlockPresence(Field field, double time) override;
+
+  //scanBlockPresence (V6 only, rebuilds the block presence sidecar reading all the file headers)
+  bool scanBlockPresence();
+
+  //getBlockRanges
+  virtual Array getBlockRanges(Field field, double time) override;
+
+  //scanBlockRanges (rebuilds the block ranges sidecar reading all the blocks)
+  bool scanBlockRanges();
+
+  //prefetchBlocks
+  virtual void prefetchBlocks(Field field, double time, const std::vector<BigInt>& blockids) override;
+
+  //prefetchBlocks (one readahead plan for all the fields and timesteps)
+  virtual void prefetchBlocks(const std::vector<Field>& fields, const std::vector< std::tuple<int, double, BigInt> >& blocks) override;
+
+  //getStoredBlockSizes (V6 only, from IdxDiskAccessHeaderCache)
+  virtual std::vector<Int64> getStoredBlockSizes(Field field, double time, const std::vector<BigInt>& blockids) override;
+
   //writeBlock
   virtual void writeBlock(SharedPtr<BlockQuery> query) override;
 
@@ -99,11 +214,49 @@ public:
   //releaseWriteLock
   virtual void releaseWriteLock(SharedPtr<BlockQuery> query) override;
 
+  //compact (V6 only, rewrites each file with blocks in HZ order and no dead space, nthreads files at a time)
+  bool compact(int nthreads = 0);
+
+  //getWriteThreadPool
+  virtual SharedPtr<ThreadPool> getWriteThreadPool() override {
+    return encode_tpool;
+  }
+
+  //getMergeThreadPool
+  virtual SharedPtr<ThreadPool> getMergeThreadPool() override {
+    return merge_tpool;
+  }
+
 private:
 
-  UniquePtr<Access>     sync, async;
-  SharedPtr<ThreadPool> async_tpool;
-  IdxFile               idxfile;
+  IdxDataset*                          dataset = nullptr;
+  UniquePtr<Access>                    sync;
+  std::vector< UniquePtr<Access> >     async;
+  std::vector< SharedPtr<ThreadPool> > async_tpool;
+  IdxFile                              idxfile;
+  int                                  max_inflight = 0;
+  Semaphore                            inflight;
+  SharedPtr<ThreadPool>                encode_tpool;
+  SharedPtr<ThreadPool>                write_tpool;
+  SharedPtr<ThreadPool>                merge_tpool;
+
+  class Readahead;
+  UniquePtr<Readahead>                 readahead;
+
+  CriticalSection                      presence_lock;
+  SharedPtr<IdxBlockPresence>          presence;
+  bool                                 bUsePresence = true;
+  std::map< std::pair<String, double>, std::vector<BigInt> > presence_updates;
+
+  CriticalSection                      ranges_lock;
+  SharedPtr<IdxBlockRanges>            ranges;
+  bool                                 bUseRanges = true;
+
+  bool                                 bDeferSidecarUpdates = false;
+  std::map< std::pair<String, double>, std::map<BigInt, std::vector<double> > > ranges_updates;
+
+  //getWorker
+  int getWorker(SharedPtr<BlockQuery> query) const;
 
 }; 
 
@@ -100,6 +100,7 @@ private:
   NetResponse handleBlockQuery       (const NetRequest& request);
   NetResponse handleBoxQuery         (const NetRequest& request);
   NetResponse handlePointQuery       (const NetRequest& request);
+  NetResponse handleBoxQueryCost     (const NetRequest& request);
 
 };
 
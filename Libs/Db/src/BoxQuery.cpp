@@ -69,6 +69,18 @@ bool BoxQuery::allocateBufferIfNeeded()
   return true;
 }
 
+/////////////////////////////////////////////////////////////
+void BoxQueryCost::write(Archive& ar) const
+{
+  ar.write("end_resolution", end_resolution);
+  ar.write("nsamples", nsamples.toString());
+  ar.write("output_bytes", output_bytes);
+  ar.write("nblocks", nblocks);
+  ar.write("nblocks_known", nblocks_known);
+  ar.write("decoded_bytes", decoded_bytes);
+  ar.write("compressed_bytes", compressed_bytes);
+}
+
 
 } //namespace Visus
 
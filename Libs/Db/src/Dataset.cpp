@@ -332,10 +332,8 @@ std::vector<int> Dataset::guessBoxQueryEndResolutions(Frustum logic_to_screen, P
 }
 
 ////////////////////////////////////////////////
-void Dataset::executeBlockQuery(SharedPtr<Access> access,SharedPtr<BlockQuery> query)
+static bool PrepareBlockQuery(SharedPtr<Access> access, SharedPtr<BlockQuery> query)
 {
-  VisusAssert(access->isReading() || access->isWriting());
-
   int mode = query->mode; 
   auto failed = [&](String reason) {
 
@@ -345,7 +343,7 @@ void Dataset::executeBlockQuery(SharedPtr<Access> access,SharedPtr<BlockQuery> q
       mode == 'r'? access->readFailed(query) : access->writeFailed(query);
    
     PrintInfo("executeBlockQUery failed", reason);
-    return;
+    return false;
   };
 
   if (!access)
@@ -371,8 +369,18 @@ void Dataset::executeBlockQuery(SharedPtr<Access> access,SharedPtr<BlockQuery> q
     query->time = cdouble(query->field.getParam("time"));
 
   query->setRunning();
+  return true;
+}
+
+////////////////////////////////////////////////
+void Dataset::executeBlockQuery(SharedPtr<Access> access,SharedPtr<BlockQuery> query)
+{
+  VisusAssert(access->isReading() || access->isWriting());
+
+  if (!PrepareBlockQuery(access, query))
+    return;
 
-  if (mode == 'r')
+  if (query->mode == 'r')
   {
     access->readBlock(query);
     BlockQuery::readBlockEvent();
@@ -385,6 +393,29 @@ void Dataset::executeBlockQuery(SharedPtr<Access> access,SharedPtr<BlockQuery> q
 
   return;
 }
+
+////////////////////////////////////////////////
+void Dataset::executeBlockQuery(SharedPtr<Access> access, std::vector< SharedPtr<BlockQuery> > queries)
+{
+  VisusAssert(access->isReading());
+
+  std::vector< SharedPtr<BlockQuery> > valid;
+  valid.reserve(queries.size());
+  for (auto query : queries)
+  {
+    VisusAssert(query->mode == 'r');
+    if (PrepareBlockQuery(access, query))
+      valid.push_back(query);
+  }
+
+  if (valid.empty())
+    return;
+
+  access->readBlocks(valid);
+
+  for (int I = 0; I < (int)valid.size(); I++)
+    BlockQuery::readBlockEvent();
+}
 
 
 ////////////////////////////////////////////////////////////////////////////////////
@@ -46,6 +46,8 @@ For support : support@visus.net
 #include <Visus/StringTree.h>
 #include <Visus/IdxDataset.h>
 #include <Visus/IdxMultipleDataset.h>
+#include <Visus/IdxDiskAccess.h>
+#include <Visus/IdxBoxQueryStream.h>
 
 
 namespace Visus {
@@ -73,6 +75,22 @@ void DbModule::attach()
 
   if (auto value = config->readInt("Configuration/OnDemandAccess/External/nconnections", 8))
     OnDemandAccess::Defaults::nconnections = value;
+
+  IdxDiskAccessHeaderCache::allocSingleton();
+  auto header_cache_max_memory = config->readString("Configuration/IdxDiskAccess/HeaderCache/max_memory");
+  if (!header_cache_max_memory.empty())
+    IdxDiskAccessHeaderCache::getSingleton()->setMaxMemory(StringUtils::getByteSizeFromString(header_cache_max_memory));
+
+  IdxPointQueryThreadPool::allocSingleton();
+
+  IdxBoxQueryPlanCache::allocSingleton();
+  auto plan_cache_max_memory = config->readString("Configuration/IdxDataset/QueryPlanCache/max_memory");
+  if (!plan_cache_max_memory.empty())
+    IdxBoxQueryPlanCache::getSingleton()->setMaxMemory(StringUtils::getByteSizeFromString(plan_cache_max_memory));
+
+  auto stream_max_memory = config->readString("Configuration/IdxDataset/BoxQueryStream/max_memory");
+  if (!stream_max_memory.empty())
+    IdxBoxQueryStream::Defaults::max_memory = StringUtils::getByteSizeFromString(stream_max_memory);
 }
 
 //////////////////////////////////////////////
@@ -81,6 +99,9 @@ void DbModule::detach()
   if (!bAttached)  return;
   bAttached = false;
   DatasetFactory::releaseSingleton();
+  IdxDiskAccessHeaderCache::releaseSingleton();
+  IdxBoxQueryPlanCache::releaseSingleton();
+  IdxPointQueryThreadPool::releaseSingleton();
   KernelModule::detach();
 }
 
@@ -40,11 +40,254 @@ For support : support@visus.net
 #include <Visus/Dataset.h>
 #include <Visus/File.h>
 #include <Visus/Encoder.h>
+#include <Visus/ByteOrder.h>
+
+#include <Visus/Utils.h>
 
 #include <cctype>
+#include <fstream>
+#include <set>
 
 namespace Visus {
 
+/*
+Shard file format (all words are Uint32 in network byte order):
+  header: magic, version, shard_bits, reserved
+  index:  2^shard_bits entries of offset_low, offset_high, size, reserved (size 0 means the block does not exist)
+  data:   encoded blocks
+
+Blocks are always appended and then the index entry is updated, a block is never overwritten in place:
+concurrent readers see either the old or the new block (the old one becomes dead space).
+*/
+enum
+{
+  ShardMagic = 0x56534844, //VSHD
+  ShardVersion = 1,
+  ShardHeaderSize = 4 * sizeof(Uint32),
+  ShardEntrySize = 4 * sizeof(Uint32)
+};
+
+////////////////////////////////////////////////////////////////////
+/*
+Usage of a bounded disk cache, shared by all the processes using the same directory:
+  <dir>/cache.usage          one line for each file: size hits last_access filename (always replaced with an atomic rename)
+  <dir>/cache.usage.journal  files written since the last flush, appended before writing them
+
+Files are never written without being in the journal, so after a crash nothing is left untracked.
+Files already in the directory when the usage file is created (e.g. written before the budget was configured) are found by a scan.
+Hits and access times are kept in memory and merged at flush time (losing them only changes the eviction order).
+*/
+class DiskAccess::Usage
+{
+public:
+
+  String dir;
+  String filename;
+  Int64  available = 0;
+  bool   bLfu = false;
+
+  //constructor
+  Usage(String dir_, Int64 available_, bool bLfu_) : dir(dir_), available(available_), bLfu(bLfu_) {
+    this->filename = Path(dir).getChild("cache.usage").toString();
+  }
+
+  //touch (a block of the file has been read)
+  void touch(String value)
+  {
+    auto& entry = touched[value];
+    entry.hits++;
+    entry.last_access = Time::now().getUTCMilliseconds();
+  }
+
+  //beginWrite (must be called before writing the file)
+  void beginWrite(String value)
+  {
+    if (journaled.insert(value).second)
+    {
+      FileUtils::lock(filename);
+      {
+        std::ofstream out((filename + ".journal").c_str(), std::ios::app | std::ios::binary);
+        out << value << "\n";
+      }
+      FileUtils::unlock(filename);
+    }
+  }
+
+  //endWrite (returns true if some file has been evicted)
+  bool endWrite(String value, Int64 nbytes)
+  {
+    touch(value);
+    written += nbytes;
+
+    //do not wait for endIO to stay (almost) inside the budget
+    return written > available / 16 && flush() > 0;
+  }
+
+  //needFlush
+  bool needFlush() const {
+    return written > 0 || (!touched.empty() && last_flush.elapsedMsec() > 30 * 1000);
+  }
+
+  //flush (merges the local counters and the journal, then evicts files down to 90% of the budget, returns the number of evicted files)
+  int flush()
+  {
+    FileUtils::lock(filename);
+
+    std::map<String, Entry> entries;
+
+    //first use
+    if (!FileUtils::existsFile(filename))
+      scan(Path(dir), entries);
+
+    {
+      std::istringstream in(Utils::loadTextDocument(filename));
+      String line;
+      while (std::getline(in, line))
+      {
+        Entry entry;
+        String name;
+        std::istringstream parse(line);
+        if (parse >> entry.size >> entry.hits >> entry.last_access && std::getline(parse, name) && name.size() > 1)
+          entries[name.substr(1)] = entry;
+      }
+    }
+
+    //files written since last flush (by any process): the size comes from the file system
+    std::set<String> dirty;
+    {
+      std::istringstream in(Utils::loadTextDocument(filename + ".journal"));
+      String line;
+      while (std::getline(in, line))
+      {
+        if (!line.empty())
+          dirty.insert(line);
+      }
+    }
+
+    Int64 now = Time::now().getUTCMilliseconds();
+    for (auto it : dirty)
+    {
+      auto& entry = entries[it];
+      entry.size = FileUtils::getFileSize(it);
+      entry.last_access = std::max(entry.last_access, now);
+    }
+
+    for (auto it : touched)
+    {
+      auto found = entries.find(it.first);
+      if (found == entries.end())
+        continue;
+      found->second.hits += it.second.hits;
+      found->second.last_access = std::max(found->second.last_access, it.second.last_access);
+    }
+
+    Int64 total = 0;
+    std::vector< std::pair<std::pair<Int64, Int64>, String> > order;
+    for (auto it = entries.begin(); it != entries.end(); )
+    {
+      if (it->second.size < 0)
+      {
+        it = entries.erase(it);
+        continue;
+      }
+      total += it->second.size;
+      order.push_back(std::make_pair(bLfu ? std::make_pair(it->second.hits, it->second.last_access) : std::make_pair(it->second.last_access, it->second.hits), it->first));
+      ++it;
+    }
+
+    int nevicted = 0;
+    if (total > available)
+    {
+      std::sort(order.begin(), order.end());
+      for (int I = 0; I < (int)order.size() && total > available - available / 10; I++)
+      {
+        String victim = order[I].second;
+        if (!FileUtils::removeFile(victim) && FileUtils::existsFile(victim))
+          continue;
+
+        total -= entries[victim].size;
+        entries.erase(victim);
+        nevicted++;
+
+        //do not leave empty directories behind
+        for (auto parent = Path(victim).getParent(); StringUtils::startsWith(parent.toString(), dir + "/", true); parent = parent.getParent())
+        {
+          if (!FileUtils::removeEmptyDirectory(parent))
+            break;
+        }
+      }
+    }
+
+    std::ostringstream out;
+    for (auto it : entries)
+      out << it.second.size << " " << it.second.hits << " " << it.second.last_access << " " << it.first << "\n";
+
+    //readers must never see a partial file, the journal is removed only when its content is safe
+    String tmp_filename = filename + ".tmp";
+    try
+    {
+      Utils::saveTextDocument(tmp_filename, out.str());
+      if (!FileUtils::moveFile(tmp_filename, filename))
+      {
+        //windows cannot rename over an existing file
+        FileUtils::removeFile(filename);
+        FileUtils::moveFile(tmp_filename, filename);
+      }
+      FileUtils::removeFile(filename + ".journal");
+    }
+    catch (...)
+    {
+      FileUtils::removeFile(tmp_filename);
+    }
+
+    FileUtils::unlock(filename);
+
+    touched.clear();
+    journaled.clear();
+    written = 0;
+    last_flush = Time::now();
+    return nevicted;
+  }
+
+private:
+
+  //_______________________________________________
+  class Entry
+  {
+  public:
+    Int64 size = 0;
+    Int64 hits = 0;
+    Int64 last_access = 0;
+  };
+
+  std::map<String, Entry> touched;
+  std::set<String>        journaled;
+  Int64                   written = 0;
+  Time                    last_flush = Time::now();
+
+  //scan
+  void scan(Path path, std::map<String, Entry>& entries) const
+  {
+    for (auto name : FileUtils::listDirectory(path))
+    {
+      auto child = path.getChild(name);
+      if (FileUtils::existsDirectory(child))
+      {
+        scan(child, entries);
+        continue;
+      }
+
+      if (StringUtils::startsWith(name, "cache.usage", true) || StringUtils::endsWith(name, ".lock", true) || StringUtils::endsWith(name, ".tmp", true))
+        continue;
+
+      auto& entry = entries[child.toString()];
+      entry.size = FileUtils::getFileSize(child);
+      entry.last_access = FileUtils::getTimeLastModified(child) * 1000;
+    }
+  }
+
+};
+
 ////////////////////////////////////////////////////////////////////
 DiskAccess::DiskAccess(Dataset* dataset,StringTree config)
 {
@@ -55,6 +298,20 @@ DiskAccess::DiskAccess(Dataset* dataset,StringTree config)
   this->bitsperblock      = default_bitsperblock;
   this->compression       = config.readString("compression", "lz4");
   this->filename_template = config.readString("filename_template", "$(prefix)/time_$(time)/$(field)/$(block).$(compression)");
+  this->shard_bits        = std::max(0, std::min(20, config.readInt("shard_bits", 0)));
+
+  if (auto available = StringUtils::getByteSizeFromString(config.readString("available", "0")))
+  {
+    FileUtils::createDirectory(this->path);
+    this->usage.reset(new Usage(this->path.toString(), available, config.readString("eviction", "lru") == "lfu"));
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+DiskAccess::~DiskAccess()
+{
+  if (usage && usage->needFlush())
+    usage->flush();
 }
 
 
@@ -66,12 +323,126 @@ String DiskAccess::getFilename(Field field,double time,BigInt blockid) const
   ret = StringUtils::replaceFirst(ret, "$(prefix)", this->path.toString());
   ret = StringUtils::replaceFirst(ret, "$(time)", StringUtils::onlyAlNum(int(time) == time ? cstring((int)time) : cstring(time)));
   ret = StringUtils::replaceFirst(ret, "$(field)", fieldname.length() < 32 ? StringUtils::onlyAlNum(fieldname) : StringUtils::computeChecksum(fieldname));
-  ret = StringUtils::replaceFirst(ret, "$(block)", StringUtils::join(StringUtils::splitInChunks(StringUtils::formatNumber("%032x", blockid), 4), "/"));
+  ret = StringUtils::replaceFirst(ret, "$(block)", StringUtils::join(StringUtils::splitInChunks(StringUtils::formatNumber("%032x", blockid >> shard_bits), 4), "/"));
   ret = StringUtils::replaceFirst(ret, "$(compression)", this->compression);
   VisusAssert(!StringUtils::contains(ret, "$"));
+  return shard_bits ? ret + ".shard" : ret;
+}
+
+////////////////////////////////////////////////////////////////////
+bool DiskAccess::openShard(String filename, String file_mode)
+{
+  //useless code, already opened (a shard opened for writing can be read too)
+  if (shard.isOpen() && shard.getFilename() == filename && (file_mode == "r" || shard.getFileMode() == file_mode))
+    return true;
+
+  shard.close();
+
+  Uint32 header[4];
+  if (shard.open(filename, file_mode))
+  {
+    if (!shard.read(0, sizeof(header), (unsigned char*)header) ||
+      ByteOrder::fromNetworkByteOrder(header[0]) != ShardMagic ||
+      ByteOrder::fromNetworkByteOrder(header[1]) != ShardVersion ||
+      ByteOrder::fromNetworkByteOrder(header[2]) != (Uint32)shard_bits)
+    {
+      PrintInfo("Wrong shard header", filename);
+      shard.close();
+      return false;
+    }
+    return true;
+  }
+
+  if (file_mode == "r" || !shard.createAndOpen(filename, file_mode))
+    return false;
+
+  //new shard, all blocks missing
+  HeapMemory headers;
+  if (!headers.resize(ShardHeaderSize + (((Int64)1) << shard_bits) * ShardEntrySize, __FILE__, __LINE__))
+  {
+    shard.close();
+    return false;
+  }
+
+  headers.fill(0);
+  header[0] = ByteOrder::toNetworkByteOrder((Uint32)ShardMagic);
+  header[1] = ByteOrder::toNetworkByteOrder((Uint32)ShardVersion);
+  header[2] = ByteOrder::toNetworkByteOrder((Uint32)shard_bits);
+  header[3] = 0;
+  memcpy(headers.c_ptr(), header, sizeof(header));
+
+  if (!shard.write(0, headers.c_size(), headers.c_ptr()))
+  {
+    shard.close();
+    FileUtils::removeFile(filename);
+    return false;
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+SharedPtr<HeapMemory> DiskAccess::readShardBlock(String filename, BigInt blockid)
+{
+  //never create a shard just to find out the block is missing (only writeShardBlock creates them)
+  if (!openShard(filename, "r"))
+    return SharedPtr<HeapMemory>();
+
+  Int64 slot = (Int64)(blockid & ((((BigInt)1) << shard_bits) - 1));
+  Uint32 entry[4];
+  if (!shard.read(ShardHeaderSize + slot * ShardEntrySize, sizeof(entry), (unsigned char*)entry))
+    return SharedPtr<HeapMemory>();
+
+  Int64 offset = ((Int64)ByteOrder::fromNetworkByteOrder(entry[1]) << 32) | (Int64)ByteOrder::fromNetworkByteOrder(entry[0]);
+  Int64 size   = (Int64)ByteOrder::fromNetworkByteOrder(entry[2]);
+  if (!offset || !size)
+    return SharedPtr<HeapMemory>();
+
+  auto ret = std::make_shared<HeapMemory>();
+  if (!ret->resize(size, __FILE__, __LINE__) || !shard.read(offset, size, ret->c_ptr()))
+    return SharedPtr<HeapMemory>();
+
   return ret;
 }
 
+////////////////////////////////////////////////////////////////////
+bool DiskAccess::writeShardBlock(String filename, BigInt blockid, SharedPtr<HeapMemory> encoded)
+{
+  //the index entry stores the size in 32 bits
+  if (encoded->c_size() > (Int64)0xffffffff)
+  {
+    PrintInfo("Block", blockid, "too big for a shard entry, size", encoded->c_size());
+    return false;
+  }
+
+  if (!openShard(filename, "rw"))
+    return false;
+
+  Int64 offset = shard.size();
+  if (offset < ShardHeaderSize || !shard.write(offset, encoded->c_size(), encoded->c_ptr()))
+    return false;
+
+  //the index entry is written only when the data is already there
+  Int64 slot = (Int64)(blockid & ((((BigInt)1) << shard_bits) - 1));
+  Uint32 entry[4];
+  entry[0] = ByteOrder::toNetworkByteOrder((Uint32)(offset & 0xffffffff));
+  entry[1] = ByteOrder::toNetworkByteOrder((Uint32)(offset >> 32));
+  entry[2] = ByteOrder::toNetworkByteOrder((Uint32)encoded->c_size());
+  entry[3] = 0;
+  return shard.write(ShardHeaderSize + slot * ShardEntrySize, sizeof(entry), (unsigned char*)entry);
+}
+
+////////////////////////////////////////////////////////////////////
+void DiskAccess::endIO()
+{
+  shard.close();
+
+  if (usage && usage->needFlush())
+    usage->flush();
+
+  Access::endIO();
+}
+
 ////////////////////////////////////////////////////////////////////
 void DiskAccess::acquireWriteLock(SharedPtr<BlockQuery> query)
 {
@@ -100,16 +471,26 @@ void DiskAccess::readBlock(SharedPtr<BlockQuery> query)
   if (query->aborted())
     return readFailed(query);
 
-  auto encoded=std::make_shared<HeapMemory>();
-  if (!encoded->resize(FileUtils::getFileSize(filename),__FILE__,__LINE__))
-    return readFailed(query);
+  SharedPtr<HeapMemory> encoded;
+  if (shard_bits)
+  {
+    encoded = readShardBlock(filename, query->blockid);
+    if (!encoded)
+      return readFailed(query);
+  }
+  else
+  {
+    encoded = std::make_shared<HeapMemory>();
+    if (!encoded->resize(FileUtils::getFileSize(filename),__FILE__,__LINE__))
+      return readFailed(query);
 
-  File file;
-  if (!file.open(filename,"r"))
-    return readFailed(query);
+    File file;
+    if (!file.open(filename,"r"))
+      return readFailed(query);
 
-  if (!file.read(0,encoded->c_size(), encoded->c_ptr()))
-    return readFailed(query);
+    if (!file.read(0,encoded->c_size(), encoded->c_ptr()))
+      return readFailed(query);
+  }
 
   auto nsamples = query->getNumberOfSamples();
   auto decoded=ArrayUtils::decodeArray(this->compression,nsamples,query->field.dtype, encoded);
@@ -120,6 +501,9 @@ void DiskAccess::readBlock(SharedPtr<BlockQuery> query)
   decoded.layout=""; //rowmajor
   query->buffer=decoded;
 
+  if (usage)
+    usage->touch(filename);
+
   return readOk(query);
 }
 
@@ -144,6 +528,25 @@ void DiskAccess::writeBlock(SharedPtr<BlockQuery> query)
   if (query->aborted())
     return writeFailed(query);
 
+  if (usage)
+    usage->beginWrite(filename);
+
+  if (shard_bits)
+  {
+    auto encoded = ArrayUtils::encodeArray(this->compression, query->buffer);
+    if (!encoded || !writeShardBlock(filename, query->blockid, encoded))
+    {
+      PrintInfo("Failed to write block filename", filename, "compression or shard write failed");
+      return writeFailed(query);
+    }
+
+    //the open shard could have been evicted
+    if (usage && usage->endWrite(filename, encoded->c_size()))
+      shard.close();
+
+    return writeOk(query);
+  }
+
   FileUtils::removeFile(filename);
 
   File file;
@@ -167,6 +570,9 @@ void DiskAccess::writeBlock(SharedPtr<BlockQuery> query)
     return writeFailed(query);
   }
 
+  if (usage)
+    usage->endWrite(filename, encoded->c_size());
+
   return writeOk(query);
 }
 
@@ -0,0 +1,112 @@
+/*-----------------------------------------------------------------------------
+Copyright(c) 2010 - 2018 ViSUS L.L.C.,
+Scientific Computing and Imaging Institute of the University of Utah
+
+ViSUS L.L.C., 50 W.Broadway, Ste. 300, 84101 - 2044 Salt Lake City, UT
+University of Utah, 72 S Central Campus Dr, Room 3750, 84112 Salt Lake City, UT
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met :
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+For additional information about this project contact : pascucci@acm.org
+For support : support@visus.net
+-----------------------------------------------------------------------------*/
+
+#include <Visus/IdxBlockPresence.h>
+#include <Visus/Array.h>
+
+namespace Visus {
+
+/////////////////////////////////////////////////////////////////////////////
+static String EncodeBitmap(const IdxBlockPresence::Bitmap& bitmap)
+{
+  if (bitmap.empty())
+    return "";
+
+  Array bytes(PointNi(std::vector<Int64>({ (Int64)(bitmap.size() + 7) / 8 })), DTypes::UINT8);
+  bytes.fillWithValue(0);
+  auto ptr = bytes.c_ptr();
+  for (size_t I = 0; I < bitmap.size(); I++)
+  {
+    if (bitmap[I])
+      ptr[I >> 3] |= (Uint8)(1 << (I & 7));
+  }
+
+  //sparse bitmaps compress very well
+  auto encoded = ArrayUtils::encodeArray("zip", bytes);
+  return encoded ? encoded->base64Encode() : "";
+}
+
+/////////////////////////////////////////////////////////////////////////////
+static SharedPtr<IdxBlockPresence::Bitmap> DecodeBitmap(String value, Int64 nblocks)
+{
+  if (nblocks <= 0)
+    return std::make_shared<IdxBlockPresence::Bitmap>();
+
+  auto encoded = HeapMemory::base64Decode(value);
+  if (!encoded)
+    return SharedPtr<IdxBlockPresence::Bitmap>();
+
+  auto bytes = ArrayUtils::decodeArray("zip", PointNi(std::vector<Int64>({ (nblocks + 7) / 8 })), DTypes::UINT8, encoded);
+  if (!bytes)
+    return SharedPtr<IdxBlockPresence::Bitmap>();
+
+  auto ret = std::make_shared<IdxBlockPresence::Bitmap>((size_t)nblocks, false);
+  auto ptr = bytes.c_ptr();
+  for (Int64 I = 0; I < nblocks; I++)
+    (*ret)[(size_t)I] = (ptr[I >> 3] >> (I & 7)) & 1;
+  return ret;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+SharedPtr<IdxBlockPresence::Bitmap> IdxBlockPresence::readValue(const StringTree& child) const
+{
+  return DecodeBitmap(child.readString("data"), child.readInt64("nblocks", 0));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+bool IdxBlockPresence::writeValue(StringTree& child, const SharedPtr<Bitmap>& value) const
+{
+  child.write("nblocks", (Int64)value->size());
+  child.write("data", EncodeBitmap(*value));
+  return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+SharedPtr<IdxBlockPresence::Bitmap> IdxBlockPresence::applyUpdates(const SharedPtr<Bitmap>& value, const std::vector<BigInt>& blockids) const
+{
+  auto bitmap = std::make_shared<Bitmap>(*value);
+  for (auto blockid : blockids)
+  {
+    if (blockid >= 0 && blockid < (BigInt)bitmap->size())
+      (*bitmap)[(size_t)blockid] = true;
+  }
+  return bitmap;
+}
+
+} //namespace Visus
+
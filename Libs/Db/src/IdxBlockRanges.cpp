@@ -0,0 +1,118 @@
+/*-----------------------------------------------------------------------------
+Copyright(c) 2010 - 2018 ViSUS L.L.C.,
+Scientific Computing and Imaging Institute of the University of Utah
+
+ViSUS L.L.C., 50 W.Broadway, Ste. 300, 84101 - 2044 Salt Lake City, UT
+University of Utah, 72 S Central Campus Dr, Room 3750, 84112 Salt Lake City, UT
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met :
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+For additional information about this project contact : pascucci@acm.org
+For support : support@visus.net
+-----------------------------------------------------------------------------*/
+
+#include <Visus/IdxBlockRanges.h>
+
+#include <limits>
+
+namespace Visus {
+
+/////////////////////////////////////////////////////////////////////////////
+Array IdxBlockRanges::createRanges(int ncomponents, Int64 nblocks)
+{
+  Array ret(PointNi(std::vector<Int64>({ 2 * (Int64)ncomponents, nblocks })), DTypes::FLOAT64);
+  auto ptr = (Float64*)ret.c_ptr();
+  for (Int64 I = 0, Tot = ret.getTotalNumberOfSamples(); I < Tot; I += 2)
+  {
+    ptr[I + 0] = +std::numeric_limits<Float64>::max();
+    ptr[I + 1] = -std::numeric_limits<Float64>::max();
+  }
+  return ret;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+std::vector<double> IdxBlockRanges::computeRanges(Array block)
+{
+  std::vector<double> ret;
+  for (int C = 0; C < block.dtype.ncomponents(); C++)
+  {
+    auto range = ArrayUtils::computeRange(block, C);
+    ret.push_back(range.from);
+    ret.push_back(range.to);
+  }
+  return ret;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+std::vector<double> IdxBlockRanges::unknownRanges(int ncomponents)
+{
+  std::vector<double> ret;
+  for (int C = 0; C < ncomponents; C++)
+  {
+    ret.push_back(-std::numeric_limits<Float64>::max());
+    ret.push_back(+std::numeric_limits<Float64>::max());
+  }
+  return ret;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+Array IdxBlockRanges::readValue(const StringTree& child) const
+{
+  auto dims = PointNi(std::vector<Int64>({ 2 * (Int64)child.readInt("ncomponents", 0), child.readInt64("nblocks", 0) }));
+  auto encoded = HeapMemory::base64Decode(child.readString("data"));
+  return encoded && dims.innerProduct() > 0 ? ArrayUtils::decodeArray("zip", dims, DTypes::FLOAT64, encoded) : Array();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+bool IdxBlockRanges::writeValue(StringTree& child, const Array& value) const
+{
+  auto encoded = ArrayUtils::encodeArray("zip", value);
+  if (!encoded)
+    return false;
+
+  child.write("ncomponents", (int)(value.dims[0] / 2));
+  child.write("nblocks", value.dims[1]);
+  child.write("data", encoded->base64Encode());
+  return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+Array IdxBlockRanges::applyUpdates(const Array& value, const std::map<BigInt, std::vector<double> >& values) const
+{
+  auto ranges = value.clone();
+  Int64 stride = ranges.dims[0], nblocks = ranges.dims[1];
+  auto ptr = (Float64*)ranges.c_ptr();
+  for (auto it : values)
+  {
+    if (it.first >= 0 && it.first < nblocks && (Int64)it.second.size() == stride)
+      std::copy(it.second.begin(), it.second.end(), ptr + (Int64)it.first * stride);
+  }
+  return ranges;
+}
+
+} //namespace Visus
@@ -0,0 +1,242 @@
+/*-----------------------------------------------------------------------------
+Copyright(c) 2010 - 2018 ViSUS L.L.C.,
+Scientific Computing and Imaging Institute of the University of Utah
+
+ViSUS L.L.C., 50 W.Broadway, Ste. 300, 84101 - 2044 Salt Lake City, UT
+University of Utah, 72 S Central Campus Dr, Room 3750, 84112 Salt Lake City, UT
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met :
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+For additional information about this project contact : pascucci@acm.org
+For support : support@visus.net
+-----------------------------------------------------------------------------*/
+
+
+#include <Visus/IdxBoxQueryPlan.h>
+
+namespace Visus {
+
+VISUS_IMPLEMENT_SINGLETON_CLASS(IdxBoxQueryPlanCache)
+
+//////////////////////////////////////////////////////////////////////////////
+String IdxBoxQueryPlan::getKey(String bitmask, const LogicSamples& logic_samples, int cur_resolution, int end_resolution, int bitsperblock)
+{
+  return concatenate(bitmask, " ", logic_samples.logic_box.toString(/*bInterleave*/false), " ", logic_samples.delta.toString(), " ", cur_resolution, " ", end_resolution, " ", bitsperblock);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+SharedPtr< std::vector<IdxBoxQueryPlan::Span> > IdxBoxQueryPlan::getSpans(BigInt blockid)
+{
+  ScopedLock lock(this->lock);
+  auto it = spans.find(blockid);
+  return it != spans.end() ? it->second : SharedPtr< std::vector<Span> >();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void IdxBoxQueryPlan::setSpans(BigInt blockid, SharedPtr< std::vector<Span> > value)
+{
+  if (!value)
+    return;
+
+  Int64 memsize = (Int64)(value->size() * sizeof(Span));
+
+  ScopedLock lock(this->lock);
+  if (spans.count(blockid))
+    return;
+
+  if (auto cache = this->cache.load())
+  {
+    if (!cache->charge(this, memsize))
+      return;
+  }
+  else if (spans_memsize + memsize > max_memory)
+  {
+    return;
+  }
+
+  spans[blockid] = value;
+  spans_memsize += memsize;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+SharedPtr< std::vector<Int32> > IdxBoxQueryPlan::getScatterOffsets(int H)
+{
+  ScopedLock lock(this->lock);
+  auto it = offsets.find(H);
+  return it != offsets.end() ? it->second : SharedPtr< std::vector<Int32> >();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void IdxBoxQueryPlan::setScatterOffsets(int H, SharedPtr< std::vector<Int32> > value)
+{
+  ScopedLock lock(this->lock);
+  if (!value || offsets.count(H))
+    return;
+
+  //cached plans pay for the table, the others always keep it (one small table for each level)
+  if (auto cache = this->cache.load())
+  {
+    if (!cache->charge(this, (Int64)(value->size() * sizeof(Int32))))
+      return;
+  }
+
+  offsets[H] = value;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+Int64 IdxBoxQueryPlan::getMemSize() const
+{
+  ScopedLock lock(const_cast<IdxBoxQueryPlan*>(this)->lock);
+  Int64 ret = (Int64)(blocks.size() * sizeof(BigInt)) + spans_memsize;
+  for (auto it : offsets)
+    ret += (Int64)(it.second->size() * sizeof(Int32));
+  return ret;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void IdxBoxQueryPlanCache::setMaxMemory(Int64 value)
+{
+  ScopedLock lock(this->lock);
+  this->max_memory = std::max((Int64)0, value);
+  while (!lru.empty() && used_memory > max_memory)
+    remove(index.find(lru.back()));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+Int64 IdxBoxQueryPlanCache::getUsedMemory() const
+{
+  ScopedLock lock(const_cast<IdxBoxQueryPlanCache*>(this)->lock);
+  return used_memory;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+SharedPtr<IdxBoxQueryPlan> IdxBoxQueryPlanCache::get(String key)
+{
+  ScopedLock lock(this->lock);
+
+  auto it = index.find(key);
+  if (it == index.end())
+  {
+    ++nmiss;
+    return SharedPtr<IdxBoxQueryPlan>();
+  }
+
+  lru.splice(lru.begin(), lru, it->second.lru);
+  ++nhit;
+  return it->second.plan;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+SharedPtr<IdxBoxQueryPlan> IdxBoxQueryPlanCache::peek(String key) const
+{
+  ScopedLock lock(const_cast<IdxBoxQueryPlanCache*>(this)->lock);
+  auto it = index.find(key);
+  return it != index.end() ? it->second.plan : SharedPtr<IdxBoxQueryPlan>();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void IdxBoxQueryPlanCache::put(SharedPtr<IdxBoxQueryPlan> plan)
+{
+  if (!plan)
+    return;
+
+  //outside the cache lock (the plan lock is taken before the cache lock, see charge)
+  Int64 memsize = plan->getMemSize();
+
+  ScopedLock lock(this->lock);
+
+  if (!max_memory || memsize > max_memory)
+    return;
+
+  auto it = index.find(plan->key);
+  if (it != index.end())
+  {
+    if (it->second.plan == plan)
+      return;
+    remove(it);
+  }
+
+  while (!lru.empty() && used_memory + memsize > max_memory)
+    remove(index.find(lru.back()));
+
+  lru.push_front(plan->key);
+
+  Cached cached;
+  cached.plan = plan;
+  cached.memsize = memsize;
+  cached.lru = lru.begin();
+  index[plan->key] = cached;
+  used_memory += memsize;
+
+  plan->cache = this;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+bool IdxBoxQueryPlanCache::charge(IdxBoxQueryPlan* plan, Int64 memsize)
+{
+  ScopedLock lock(this->lock);
+
+  auto it = index.find(plan->key);
+  if (it == index.end() || it->second.plan.get() != plan)
+    return false;
+
+  //the plan is in use, make room evicting the others
+  lru.splice(lru.begin(), lru, it->second.lru);
+  while (used_memory + memsize > max_memory && lru.back() != plan->key)
+    remove(index.find(lru.back()));
+
+  if (used_memory + memsize > max_memory)
+    return false;
+
+  it->second.memsize += memsize;
+  used_memory += memsize;
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void IdxBoxQueryPlanCache::clear()
+{
+  ScopedLock lock(this->lock);
+  while (!lru.empty())
+    remove(index.find(lru.back()));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void IdxBoxQueryPlanCache::remove(std::map<String, Cached>::iterator it)
+{
+  VisusAssert(it != index.end());
+
+  //the plan does not lock the cache to check this, it finds out it is not cached anymore in charge
+  it->second.plan->cache = nullptr;
+  used_memory -= it->second.memsize;
+  lru.erase(it->second.lru);
+  index.erase(it);
+}
+
+} //namespace Visus
+
@@ -0,0 +1,228 @@
+/*-----------------------------------------------------------------------------
+Copyright(c) 2010 - 2018 ViSUS L.L.C.,
+Scientific Computing and Imaging Institute of the University of Utah
+
+ViSUS L.L.C., 50 W.Broadway, Ste. 300, 84101 - 2044 Salt Lake City, UT
+University of Utah, 72 S Central Campus Dr, Room 3750, 84112 Salt Lake City, UT
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met :
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+For additional information about this project contact : pascucci@acm.org
+For support : support@visus.net
+-----------------------------------------------------------------------------*/
+
+#include <Visus/IdxBoxQueryStream.h>
+#include <Visus/IdxDataset.h>
+#include <Visus/Access.h>
+
+namespace Visus {
+
+Int64 IdxBoxQueryStream::Defaults::max_memory = 256 * 1024 * 1024;
+
+//////////////////////////////////////////////////////////////////////////////
+static Int64 FloorDiv(Int64 a, Int64 b) {
+  return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+IdxBoxQueryStream::IdxBoxQueryStream(IdxDataset* dataset_, SharedPtr<Access> access_, SharedPtr<BoxQuery> query_, PointNi tile_size_, Int64 max_memory_)
+  : dataset(dataset_), access(access_), query(query_), max_memory(max_memory_ > 0 ? max_memory_ : Defaults::max_memory)
+{
+  if (!dataset || !access || !query)
+    ThrowException("wrong arguments");
+
+  if (!query->isRunning())
+    return;
+
+  if (query->mode != 'r')
+  {
+    query->setFailed("only read queries can be streamed");
+    return;
+  }
+
+  if (query->filter.enabled)
+  {
+    query->setFailed("filters cannot be streamed, disable them");
+    return;
+  }
+
+  this->logic_samples = query->logic_samples;
+  if (!logic_samples.valid())
+  {
+    query->setFailed("wrong logic samples");
+    return;
+  }
+
+  int pdim = logic_samples.nsamples.getPointDim();
+  this->tile_size = tile_size_.getPointDim() == pdim ? tile_size_ : logic_samples.nsamples;
+
+  //power of 2 tiles, never bigger than needed
+  for (int D = 0; D < pdim; D++)
+  {
+    auto value = std::max((Int64)1, std::min(tile_size[D], Utils::getPowerOf2(logic_samples.nsamples[D])));
+    tile_size[D] = Utils::getPowerOf2(value) > value ? Utils::getPowerOf2(value) >> 1 : value;
+  }
+
+  //one tile buffer takes at most half of the budget, the rest is for the blocks in flight
+  while (query->field.dtype.getByteSize(tile_size) > max_memory / 2)
+  {
+    int D = tile_size.max_element_index();
+    if (tile_size[D] == 1)
+      break;
+    tile_size[D] >>= 1;
+  }
+
+  if (query->field.dtype.getByteSize(tile_size) > max_memory / 2)
+  {
+    query->setFailed(cstring("max_memory", max_memory, "too small"));
+    return;
+  }
+
+  //tiles are aligned to the global grid of the query samples
+  this->first  = PointNi(pdim);
+  this->ntiles = PointNi(pdim);
+  for (int D = 0; D < pdim; D++)
+  {
+    auto P1 = logic_samples.logic_box.p1[D] >> logic_samples.shift[D];
+    auto P2 = logic_samples.logic_box.p2[D] >> logic_samples.shift[D];
+    first[D]  = FloorDiv(P1, tile_size[D]);
+    ntiles[D] = FloorDiv(P2 - 1, tile_size[D]) - first[D] + 1;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+IdxBoxQueryStream::~IdxBoxQueryStream()
+{
+}
+
+//////////////////////////////////////////////////////////////////////////////
+BoxNi IdxBoxQueryStream::getTileLogicBox(Int64 I) const
+{
+  int pdim = tile_size.getPointDim();
+  BoxNi ret = BoxNi(PointNi(pdim), PointNi(pdim));
+  for (int D = 0; D < pdim; D++)
+  {
+    auto k = first[D] + I % ntiles[D];
+    I /= ntiles[D];
+    ret.p1[D] = std::max(logic_samples.logic_box.p1[D], (k + 0) * tile_size[D] << logic_samples.shift[D]);
+    ret.p2[D] = std::min(logic_samples.logic_box.p2[D], (k + 1) * tile_size[D] << logic_samples.shift[D]);
+  }
+  return ret;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+SharedPtr<BoxQuery> IdxBoxQueryStream::createTileQuery(Int64 I)
+{
+  auto logic_box = getTileLogicBox(I);
+
+  auto ret = dataset->createBoxQuery(logic_box, query->field, query->time, 'r', query->aborted);
+  ret->start_resolution = query->start_resolution;
+  ret->end_resolutions = { query->end_resolution };
+  ret->disableFilters();
+  ret->value_range = query->value_range;
+  ret->value_range.npruned = 0;
+  ret->max_read_memory = max_memory / 2;
+
+  dataset->beginBoxQuery(ret);
+
+  if (!ret->isRunning())
+  {
+    query->setFailed(cstring("cannot begin tile", I, ret->errormsg));
+    return SharedPtr<BoxQuery>();
+  }
+
+  if (ret->logic_samples.logic_box != logic_box || ret->logic_samples.delta != logic_samples.delta)
+  {
+    query->setFailed(cstring("tile", I, "is not aligned to the query samples"));
+    return SharedPtr<BoxQuery>();
+  }
+
+  return ret;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void IdxBoxQueryStream::prefetch(SharedPtr<BoxQuery> tile)
+{
+  //the plan is kept in the query (and in the plan cache) so the blocks are not collected twice
+  tile->plan = dataset->getBoxQueryPlan(tile.get(), access->bitsperblock);
+  if (!tile->plan || tile->plan->blocks.empty())
+    return;
+
+  access->beginIO('r');
+  access->prefetchBlocks(tile->field, tile->time, tile->plan->blocks);
+  access->endIO();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+bool IdxBoxQueryStream::next()
+{
+  //release the previous tile before allocating the next one
+  current.reset();
+
+  if (!query->isRunning() || cursor >= getNumberOfTiles())
+    return false;
+
+  if (query->aborted())
+  {
+    query->setFailed("query aborted");
+    return false;
+  }
+
+  auto tile = prefetched ? prefetched : createTileQuery(cursor);
+  prefetched.reset();
+  if (!tile)
+    return false;
+
+  if (!dataset->executeBoxQuery(access, tile))
+  {
+    query->setFailed(cstring("tile", cursor, "failed", tile->errormsg));
+    return false;
+  }
+  query->value_range.npruned += tile->value_range.npruned;
+
+  current = tile;
+  ++cursor;
+
+  //the blocks of the next tile are announced while the caller consumes this one
+  if (cursor < getNumberOfTiles())
+  {
+    prefetched = createTileQuery(cursor);
+    if (prefetched)
+      prefetch(prefetched);
+  }
+  else
+  {
+    query->setCurrentResolution(query->end_resolution);
+    query->setOk();
+  }
+
+  return true;
+}
+
+} //namespace Visus
+
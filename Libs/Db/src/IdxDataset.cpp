@@ -38,12 +38,18 @@ For support : support@visus.net
 
 #include <Visus/IdxDataset.h>
 #include <Visus/IdxDiskAccess.h>
+#include <Visus/IdxBoxQueryPlan.h>
+#include <Visus/IdxBoxQueryStream.h>
 #include <Visus/IdxHzOrder.h>
 #include <Visus/IdxFilter.h>
 #include <Visus/IdxMultipleAccess.h>
 #include <Visus/IdxMultipleDataset.h>
 #include <Visus/OnDemandAccess.h>
 #include <Visus/ModVisusAccess.h>
+#include <Visus/RamAccess.h>
+
+#include <limits>
+#include <tuple>
 
 namespace Visus {
 
@@ -295,6 +301,66 @@ class InsertBlockQueryHzOrderSamplesToBoxQuery
 {
 public:
 
+  //copySamples (num samples following the level address deltas cc)
+  template <class Sample>
+  static inline void copySamples(GetSamples<Sample>& Wbox, GetSamples<Sample>& Rbox, bool bInvertOrder, int pdim, const PointNi* cc, const PointNi& stride, const PointNi& shift, Int64 hzfrom, Int64 from, Int64 num)
+  {
+    auto& Windex=bInvertOrder? hzfrom :   from;
+    auto& Rindex=bInvertOrder?   from : hzfrom;
+
+    #define EXPRESSION(num) stride[num] * ((*cc)[num] << shift[num]) 
+    switch (pdim) {
+    case 2: for (; num--; ++hzfrom, ++cc) { Wbox[Windex] = Rbox[Rindex]; from += EXPRESSION(0) + EXPRESSION(1); } break;
+    case 3: for (; num--; ++hzfrom, ++cc) { Wbox[Windex] = Rbox[Rindex]; from += EXPRESSION(0) + EXPRESSION(1) + EXPRESSION(2); } break;
+    case 4: for (; num--; ++hzfrom, ++cc) { Wbox[Windex] = Rbox[Rindex]; from += EXPRESSION(0) + EXPRESSION(1) + EXPRESSION(2) + EXPRESSION(3); } break; 
+    case 5: for (; num--; ++hzfrom, ++cc) { Wbox[Windex] = Rbox[Rindex]; from += EXPRESSION(0) + EXPRESSION(1) + EXPRESSION(2) + EXPRESSION(3) + EXPRESSION(4); } break;
+    default: ThrowException("internal error"); break;
+    }
+    #undef EXPRESSION
+  }
+
+  //scatterSamples (specialized version of copySamples: the query offsets of the samples come from a precomputed table, so there is no loop carried dependency)
+  template <class Sample>
+  static inline void scatterSamples(GetSamples<Sample>& Wbox, GetSamples<Sample>& Rbox, bool bInvertOrder, const Int32* offsets, Int64 hzfrom, Int64 from, Int64 num)
+  {
+    if (bInvertOrder)
+    {
+      for (Int64 I = 0; I < num; I++)
+        Wbox[hzfrom + I] = Rbox[from + offsets[I]];
+    }
+    else
+    {
+      for (Int64 I = 0; I < num; I++)
+        Wbox[from + offsets[I]] = Rbox[hzfrom + I];
+    }
+  }
+
+  //getScatterOffsets (query offsets of the first cachable samples of level H, the same for all the blocks of the plan; empty if they do not fit in Int32)
+  static SharedPtr< std::vector<Int32> > getScatterOffsets(IdxBoxQueryPlan* plan, const IdxBoxQueryHzAddressConversion::Level& fllevel, int H, int cachable, const PointNi& stride, const PointNi& shift)
+  {
+    if (auto ret = plan->getScatterOffsets(H))
+      return ret;
+
+    auto ret = std::make_shared< std::vector<Int32> >(cachable);
+    const PointNi* cc = (const PointNi*)fllevel.cached_points->c_ptr();
+    Int64 from = 0;
+    for (int I = 0; I < cachable; I++, cc++)
+    {
+      if (from < std::numeric_limits<Int32>::min() || from > std::numeric_limits<Int32>::max())
+      {
+        ret->clear();
+        break;
+      }
+
+      (*ret)[I] = (Int32)from;
+      for (int D = 0; D < fllevel.pdim; D++)
+        from += stride[D] * ((*cc)[D] << shift[D]);
+    }
+
+    plan->setScatterOffsets(H, ret);
+    return ret;
+  }
+
   //execute
   template <class Sample>
   bool execute(IdxDataset*  vf,BoxQuery* query,BlockQuery* block_query)
@@ -330,6 +396,44 @@ public:
     auto address_conversion = vf->hzaddress_conversion_boxquery;
     VisusReleaseAssert(address_conversion);
 
+    //the plan can be stale (e.g. the query moved to the next resolution)
+    auto plan = query->plan;
+    if (plan && !plan->matches(query->logic_samples, query->getCurrentResolution(), query->getEndResolution(), bitsperblock))
+      plan.reset();
+
+    //replay the spans recorded by a previous query with the same plan
+    if (auto spans = plan ? plan->getSpans(block_query->blockid) : SharedPtr< std::vector<IdxBoxQueryPlan::Span> >())
+    {
+      PointNi stride = query->getNumberOfSamples().stride();
+      PointNi qshift = query->logic_samples.shift;
+      int lastH = -1; PointNi shift; const Int32* offsets = nullptr;
+      SharedPtr< std::vector<Int32> > OFFSETS;
+      auto check_aborted = query->aborted.checkEvery(64);
+      for (const auto& span : *spans)
+      {
+        if (check_aborted())
+          return false;
+
+        const auto& fllevel = *(address_conversion->levels[span.H]);
+
+        if (span.H != lastH)
+        {
+          lastH = span.H;
+          shift = vf->getLevelSamples(span.H).shift - qshift;
+          OFFSETS = getScatterOffsets(plan.get(), fllevel, span.H, std::min(fllevel.num, samplesperblock), stride, shift);
+          offsets = OFFSETS->empty() ? nullptr : OFFSETS->data();
+        }
+
+        if (offsets)
+          scatterSamples(Wbox, Rbox, bInvertOrder, offsets, span.hzfrom, span.from, span.num);
+        else
+          copySamples(Wbox, Rbox, bInvertOrder, fllevel.pdim, (PointNi*)fllevel.cached_points->c_ptr(), stride, shift, span.hzfrom, span.from, span.num);
+      }
+      return true;
+    }
+
+    auto spans = plan ? std::make_shared< std::vector<IdxBoxQueryPlan::Span> >() : SharedPtr< std::vector<IdxBoxQueryPlan::Span> >();
+
     int              numused=0;
     int              bit;
     Int64 delta;
@@ -374,6 +478,10 @@ public:
     
       //i need this to "split" the fast loop in two chunks
       VisusAssert(cachable>0 && cachable<=samplesperblock);
+
+      //specialized kernel (needs the plan to share the offsets between blocks)
+      auto OFFSETS = plan ? getScatterOffsets(plan.get(), fllevel, H, cachable, stride, lshift - qshift) : SharedPtr< std::vector<Int32> >();
+      const Int32* offsets = OFFSETS && !OFFSETS->empty() ? OFFSETS->data() : nullptr;
     
       //push root in the kdtree
       {
@@ -383,9 +491,10 @@ public:
         PUSH();
       }
 
+      auto check_aborted = aborted.checkEvery(1024);
       while (!EMPTY())
       {
-        if (aborted())
+        if (check_aborted())
           return false;
 
         POP();
@@ -413,13 +522,12 @@ public:
 
           Int64 from = stride.dotProduct((P-query_p1).rightShift(qshift));
 
-          auto& Windex=bInvertOrder? hzfrom :   from;
-          auto& Rindex=bInvertOrder?   from : hzfrom;
-
           auto shift = (lshift - qshift);
 
           //slow version (enable it if you have problems)
 #if 0
+          auto& Windex=bInvertOrder? hzfrom :   from;
+          auto& Rindex=bInvertOrder?   from : hzfrom;
           for (;num--;++hzfrom,++cc)
           {
             from = stride.dotProduct((P-query_p1).rightShift(qshift));
@@ -428,16 +536,13 @@ public:
           }
           //fast version
 #else
+          if (spans)
+            spans->push_back(IdxBoxQueryPlan::Span({ hzfrom, from, num, H }));
 
-          #define EXPRESSION(num) stride[num] * ((*cc)[num] << shift[num]) 
-          switch (fllevel.pdim) {
-          case 2: for (; num--; ++hzfrom, ++cc) { Wbox[Windex] = Rbox[Rindex]; from += EXPRESSION(0) + EXPRESSION(1); } break;
-          case 3: for (; num--; ++hzfrom, ++cc) { Wbox[Windex] = Rbox[Rindex]; from += EXPRESSION(0) + EXPRESSION(1) + EXPRESSION(2); } break;
-          case 4: for (; num--; ++hzfrom, ++cc) { Wbox[Windex] = Rbox[Rindex]; from += EXPRESSION(0) + EXPRESSION(1) + EXPRESSION(2) + EXPRESSION(3); } break; 
-          case 5: for (; num--; ++hzfrom, ++cc) { Wbox[Windex] = Rbox[Rindex]; from += EXPRESSION(0) + EXPRESSION(1) + EXPRESSION(2) + EXPRESSION(3) + EXPRESSION(4); } break;
-          default: ThrowException("internal error"); break;
-          }
-          #undef EXPRESSION
+          if (offsets)
+            scatterSamples(Wbox, Rbox, bInvertOrder, offsets, hzfrom, from, num);
+          else
+            copySamples(Wbox, Rbox, bInvertOrder, fllevel.pdim, cc, stride, shift, hzfrom, from, num);
 #endif
 
           hz+=numpoints;
@@ -454,6 +559,10 @@ public:
     }
 
     VisusAssert (numused>0);
+
+    if (plan)
+      plan->setSpans(block_query->blockid, spans);
+
     return true;
 
     #undef PUSH
@@ -483,7 +592,7 @@ LogicSamples IdxDataset::getLevelSamples(int H)
 }
 
 ///////////////////////////////////////////////////////////////////////////////////
-void IdxDataset::compressDataset(std::vector<String> compression, Array data)
+void IdxDataset::compressDataset(std::vector<String> compression, Array data, int nthreads)
 {
   // for future version: here I'm making the assumption that a file contains multiple fields
   if (idxfile.version != 6)
@@ -508,6 +617,67 @@ void IdxDataset::compressDataset(std::vector<String> compression, Array data)
     idxfile.save(filename);
   }
 
+  //work is partitioned by file, so no two workers share a file (or a file lock)
+  //with block interleaving the first blocks of the files are consecutive, and a file contains blockid+interleaving*I
+  BigInt total_blocks = getTotalNumberOfBlocks();
+  Int64  interleaving = std::max(1, idxfile.block_interleaving);
+  std::vector< std::pair<double, BigInt> > files;
+  for (auto time : idxfile.timesteps.asVector())
+  {
+    for (BigInt first = 0; first < total_blocks; first += interleaving * idxfile.blocksperfile)
+    {
+      for (BigInt blockid = first; blockid < first + interleaving && blockid < total_blocks; blockid++)
+        files.push_back(std::make_pair(time, blockid));
+    }
+  }
+
+  //compressFile
+  auto compressFile = [&](SharedPtr<Access> Raccess, SharedPtr<Access> Waccess, double time, BigInt first_block)
+  {
+    int nwritten = 0;
+    for (BigInt blockid = first_block; blockid < total_blocks && idxfile.getFirstBlockInFile(blockid) == first_block; blockid += interleaving)
+    {
+      for (auto Rfield : idxfile.fields)
+      {
+        //could fail because block does not exist
+        auto read_block = createBlockQuery(blockid, Rfield, time, 'r');
+        if (!executeBlockQueryAndWait(Raccess, read_block))
+          continue;
+
+        //compression can depend on level
+        auto HzStart = Waccess->getStartAddress(read_block->blockid);
+        int H = HzOrder::getAddressResolution(idxfile.bitmask, HzStart);
+        VisusReleaseAssert(H >= 0 && H < compression.size());
+
+        auto Wfield = Rfield;
+        Wfield.default_compression = compression[H];
+        auto write_block = createBlockQuery(read_block->blockid, Wfield, read_block->time, 'w');
+        write_block->buffer = read_block->buffer;
+        VisusReleaseAssert(executeBlockQueryAndWait(Waccess, write_block));
+        nwritten++;
+      }
+    }
+    return nwritten;
+  };
+
+  //each worker has its own accesses and takes the next file; the sidecar updates of a worker are applied once at the end
+  int nworkers = std::max(1, nthreads);
+  auto tpool = nthreads > 0 ? std::make_shared<ThreadPool>("IdxDataset Compress", nthreads) : SharedPtr<ThreadPool>();
+  std::atomic<int> next_file(0);
+  std::atomic<int> ndone(0);
+  Time t1 = Time::now();
+  CriticalSection progress_lock;
+  Time last_progress = t1;
+  auto printProgress = [&]() {
+    int done = ++ndone;
+    ScopedLock lock(progress_lock);
+    if (done == (int)files.size() || last_progress.elapsedSec() >= 5.0)
+    {
+      PrintInfo("compressDataset", done, "/", files.size(), "files done in", t1.elapsedSec(), "sec");
+      last_progress = Time::now();
+    }
+  };
+
   if (data)
   {
     //data will replace current data
@@ -518,42 +688,38 @@ void IdxDataset::compressDataset(std::vector<String> compression, Array data)
     VisusAssert(query->getNumberOfSamples() == data.dims);
     query->buffer = data;
 
-    auto Waccess = std::make_shared<IdxDiskAccess>(this);
-    Waccess->disableWriteLock();
-    Waccess->disableAsync();
-
-    auto Raccess = createRamAccess(/* no memory limit*/0);
-    Raccess->disableWriteLock();
-    VisusReleaseAssert(executeBoxQuery(Raccess, query));
+    auto ram = std::dynamic_pointer_cast<RamAccess>(createRamAccess(/* no memory limit*/0));
+    ram->disableWriteLock();
+    VisusReleaseAssert(executeBoxQuery(ram, query));
 
     //read blocks are in RAM assuming there is no file yet stored on disk
-    Raccess->beginRead();
-    Waccess->beginWrite();
-    for (auto time : idxfile.timesteps.asVector())
+    for (int W = 0; W < nworkers; W++)
     {
-      for (BigInt blockid = 0, total_blocks = getTotalNumberOfBlocks(); blockid < total_blocks; blockid++)
-      {
-        for (auto Rfield : idxfile.fields)
+      ThreadPool::push(tpool, [&]() {
+
+        auto Raccess = std::dynamic_pointer_cast<RamAccess>(createRamAccess(0));
+        Raccess->shareMemoryWith(ram);
+
+        auto Waccess = std::make_shared<IdxDiskAccess>(this, StringTree("access").write("disable_async", true));
+        Waccess->disableWriteLock();
+        Waccess->enableDirectIO();
+        Waccess->deferBlockSidecarUpdates();
+
+        Raccess->beginRead();
+        for (int I = next_file++; I < (int)files.size(); I = next_file++)
         {
-          auto read_block = createBlockQuery(blockid, Rfield, time, 'r');
-          if (!executeBlockQueryAndWait(Raccess, read_block))
-            continue;
-
-          //compression can depend on level
-          auto HzStart = Waccess->getStartAddress(read_block->blockid);
-          int H = HzOrder::getAddressResolution(idxfile.bitmask, HzStart);
-          VisusReleaseAssert(H >= 0 && H < compression.size());
-
-          auto Wfield = Rfield;
-          Wfield.default_compression = compression[H];
-          auto write_block = createBlockQuery(read_block->blockid, Wfield, read_block->time, 'w');
-          write_block->buffer = read_block->buffer;
-          VisusReleaseAssert(executeBlockQueryAndWait(Waccess, write_block));
+          Waccess->beginWrite();
+          compressFile(Raccess, Waccess, files[I].first, files[I].second);
+          Waccess->endWrite();
+          printProgress();
         }
-      }
+        Raccess->endRead();
+        Waccess->flushBlockSidecarUpdates();
+      });
     }
-    Raccess->endRead();
-    Waccess->endWrite();
+
+    if (tpool)
+      tpool->waitAll();
   }
   else
   {
@@ -567,90 +733,61 @@ void IdxDataset::compressDataset(std::vector<String> compression, Array data)
     compressed_idx_file.filename_template = idxfile.filename_template + suffix;
     compressed_idx_file.save(compressed_idx_filename);
 
-    auto Waccess = std::make_shared<IdxDiskAccess>(this, compressed_idx_file);
-    auto Raccess = std::make_shared<IdxDiskAccess>(this, idxfile);
-
-    Raccess->disableAsync();
-    Raccess->disableWriteLock();
-
-    Waccess->disableWriteLock();
-    Waccess->disableAsync();
-
-    for (auto time : idxfile.timesteps.asVector())
+    for (int W = 0; W < nworkers; W++)
     {
-      String prev_filename;
-      auto setFilename = [&](String value)
-      {
-        //wait for a filename change
-        if (prev_filename == value)
-          return;
+      ThreadPool::push(tpool, [&]() {
 
-        // close any read file handle only if it's the last read op
-        if (value.empty())
-          Raccess->endRead();
+        auto Raccess = std::make_shared<IdxDiskAccess>(this, idxfile, StringTree("access").write("disable_async", true));
+        Raccess->disableWriteLock();
+        Raccess->enableDirectIO();
 
-        //close any write file handle
-        Waccess->endWrite();
+        //the sidecars of the original dataset are updated, after the rename the blocks are the same
+        auto Waccess = std::make_shared<IdxDiskAccess>(this, compressed_idx_file, StringTree("access").write("disable_async", true));
+        Waccess->disableWriteLock();
+        Waccess->enableDirectIO();
+        Waccess->deferBlockSidecarUpdates();
 
-        //mv filename.~compressed -> filename
-        if (!prev_filename.empty())
+        for (int I = next_file++; I < (int)files.size(); I = next_file++)
         {
-          VisusReleaseAssert(FileUtils::removeFile(prev_filename));
-          VisusReleaseAssert(FileUtils::moveFile(prev_filename + suffix, prev_filename));
-        }
-
-        prev_filename = value;
+          auto it = files[I];
+          String filename = Raccess->getFilename(idxfile.fields[0], it.first, it.second);
+          if (FileUtils::existsFile(filename))
+          {
+            //remove any file coming from an old compression process
+            FileUtils::removeFile(filename + suffix);
+
+            Raccess->beginRead();
+            Waccess->beginWrite();
+            int nwritten = compressFile(Raccess, Waccess, it.first, it.second);
+            Raccess->endRead();
+            Waccess->endWrite();
+
+            //mv filename.~compressed -> filename
+            if (nwritten)
+            {
+              VisusReleaseAssert(FileUtils::removeFile(filename));
+              VisusReleaseAssert(FileUtils::moveFile(filename + suffix, filename));
+
+              //the file can be replaced within the same second with the same size
+              if (auto cache = IdxDiskAccessHeaderCache::getSingleton())
+                cache->invalidate(filename);
+            }
+          }
 
-        if (value.empty())
-        {
-          Raccess->beginRead();
-        }
-        else
-        {
-          //remove any file coming from an old compression process
-          FileUtils::removeFile(value + suffix);
+          printProgress();
         }
 
-        Waccess->beginWrite();
-      };
-
-      Raccess->beginRead();
-      Waccess->beginWrite();
-      for (BigInt blockid = 0, total_blocks = getTotalNumberOfBlocks(); blockid < total_blocks; blockid++)
-      {
-        for (auto Rfield : idxfile.fields)
-        {
-          auto filename = Raccess->getFilename(Rfield, time, blockid);
-          auto read_block = createBlockQuery(blockid, Rfield, time, 'r');
-
-          //could fail because block does not exist
-          if (!executeBlockQueryAndWait(Raccess, read_block))
-            continue;
-
-          //prepare for writing... 
-          setFilename(filename);
-
-          //compression can depend on level
-          auto HzStart = Waccess->getStartAddress(read_block->blockid);
-          int H = HzOrder::getAddressResolution(idxfile.bitmask, HzStart);
-          VisusReleaseAssert(H >= 0 && H < compression.size());
-
-          auto Wfield = Rfield;
-          Wfield.default_compression = compression[H];
-          auto write_block = createBlockQuery(read_block->blockid, Wfield, read_block->time, 'w');
-          write_block->buffer = read_block->buffer;
-          VisusReleaseAssert(executeBlockQueryAndWait(Waccess, write_block));
-        }
-      }
-      setFilename("");
-      Raccess->endRead();
-      Waccess->endWrite();
+        Waccess->flushBlockSidecarUpdates();
+      });
     }
-    
+
+    if (tpool)
+      tpool->waitAll();
+
     VisusReleaseAssert(FileUtils::existsFile(compressed_idx_filename));
     FileUtils::removeFile(compressed_idx_filename);
   }
-}
+}
 
 
 ///////////////////////////////////////////////////////////////////////////////////
@@ -1189,111 +1326,86 @@ bool IdxDataset::executeBoxQueryOnServer(SharedPtr<BoxQuery> query)
 
 
 ///////////////////////////////////////////////////////////////////////////////////////
-bool IdxDataset::executeBoxQuery(SharedPtr<Access> access, SharedPtr<BoxQuery> query)
+static bool BoxQueryCoversBlockQuery(BoxQuery* query, BlockQuery* block_query, int bitsperblock)
 {
-  if (!query)
+  //block 0 contains samples of several levels, some of them could be outside the query resolution range
+  if (block_query->blockid == 0 || query->filter.dataset_filter)
     return false;
 
-  if (!(query->isRunning() && query->getCurrentResolution() < query->getEndResolution()))
+  auto bitmask = block_query->dataset->getBitmask();
+  int H = HzOrder::getAddressResolution(bitmask, block_query->blockid << bitsperblock);
+  if (H <= query->getCurrentResolution() || H > query->getEndResolution())
     return false;
 
-  if (query->aborted())
-  {
-    query->setFailed("query aborted");
+  //all block samples must be query samples
+  const auto& Q = query->logic_samples;
+  const auto& B = block_query->logic_samples;
+  if (!Q.valid() || !B.valid())
     return false;
-  }
 
-  //for 'r' queries I can postpone the allocation
-  if (query->mode == 'w' && !query->buffer)
+  for (int D = 0; D < B.logic_box.getPointDim(); D++)
   {
-    query->setFailed("write buffer not set");
-    return false;
+    Int64 first = B.logic_box.p1[D];
+    Int64 last  = first + (B.nsamples[D] - 1) * B.delta[D];
+    if (first < Q.logic_box.p1[D] || last >= Q.logic_box.p2[D] || (first - Q.logic_box.p1[D]) % Q.delta[D] || B.delta[D] % Q.delta[D])
+      return false;
   }
 
-  if (!access)
-    return executeBoxQueryOnServer(query);
-
-  VisusAssert(access);
-
-  bool bWriting = query->mode == 'w';
-  bool bReading = query->mode == 'r';
-
-  const Field& field = query->field;
-  double        time = query->time;
-
-  int cur_resolution = query->getCurrentResolution();
-  int end_resolution = query->end_resolution;
-
-  if (!query->allocateBufferIfNeeded())
-    return false;
+  return true;
+}
 
-  //filter enabled... need to go level by level
-  if (auto filter = query->filter.dataset_filter)
+///////////////////////////////////////////////////////////////////////////////////////
+static void MergeBoxQueriesWithBlockQueryWhenReady(IdxDataset* dataset, WaitAsync< Future<Void> >& async_read, SharedPtr<ThreadPool> merge_tpool, std::vector< SharedPtr<BoxQuery> > queries, SharedPtr<BlockQuery> read_block)
+{
+  //serial: the merge runs on the thread waiting for the reads
+  if (!merge_tpool)
   {
-    VisusAssert(bReading);
-
-    //need to go level by level to rebuild the original data (top-down)
-    for (int H = cur_resolution + 1; H <= end_resolution; H++)
+    async_read.pushRunning(read_block->done).when_ready([dataset, queries, read_block](Void)
     {
-      BoxNi adjusted_logic_box = adjustBoxQueryFilterBox(query.get(), filter.get(), query->filter.adjusted_logic_box, H);
-
-      auto Wquery = createBoxQuery(adjusted_logic_box, query->field, query->time, 'r', query->aborted);
-      Wquery->setResolutionRange(0, H);
-      Wquery->disableFilters();
-
-      beginBoxQuery(Wquery);
-
-      //cannot get samples yet
-      if (!Wquery->isRunning())
-      {
-        VisusAssert(cur_resolution == -1);
-        VisusAssert(!query->filter.query);
-        continue;
-      }
-
-      //try to merge previous results
-      if (auto Rquery = query->filter.query)
+      //I don't care if the read fails...
+      for (auto query : queries)
       {
-        if (!Wquery->allocateBufferIfNeeded())
-          return false;
-
-        //interpolate samples seems to be wrong here, produces a lot of artifacts (see david_wavelets)! 
-        //could be that I'm inserting wrong coefficients?
-        //for now insertSamples seems to work just fine, "interpolating" missing blocks/samples
-        if (!insertSamples(Wquery->logic_samples, Wquery->buffer, Rquery->logic_samples, Rquery->buffer, Wquery->aborted))
-          return false;
-
-        //note: start_resolution/end_resolution do not change
-        Wquery->setCurrentResolution(Rquery->getCurrentResolution());
+        if (!query->aborted() && read_block->ok())
+          dataset->mergeBoxQueryWithBlockQuery(query, read_block);
       }
 
-      if (!this->executeBoxQuery(access, Wquery))
-        return false;
-
-      filter->internalComputeFilter(Wquery.get(), /*bInverse*/true);
+      //the block is not needed anymore
+      read_block->buffer = Array();
+    });
+    return;
+  }
 
-      query->filter.query = Wquery;
-    }
+  //parallel: no ordering is needed since every block writes its own samples of the query buffer 
+  //(block 0 the samples of levels [0,bitsperblock], any other block the samples of one level >bitsperblock)
+  std::vector< Promise<Void> > merged(queries.size());
+  for (auto& it : merged)
+    async_read.pushRunning(it.get_future());
 
-    //cannot get samples yet... returning failed as a query without filters...
-    if (!query->filter.query)
+  auto pending = std::make_shared< std::atomic<int> >((int)queries.size());
+  read_block->done.when_ready([dataset, queries, read_block, merge_tpool, merged, pending](Void)
+  {
+    for (int I = 0; I < (int)queries.size(); I++)
     {
-      VisusAssert(false);//technically this should not happen since the outside query has got some samples
-      return false;
-    }
-
-    query->logic_samples = query->filter.query->logic_samples;
-    query->buffer = query->filter.query->buffer;
+      auto query = queries[I];
+      auto done = merged[I];
+      ThreadPool::push(merge_tpool, [dataset, query, read_block, done, pending]() mutable
+      {
+        if (!query->aborted() && read_block->ok())
+          dataset->mergeBoxQueryWithBlockQuery(query, read_block);
 
-    VisusAssert(query->buffer.dims == query->getNumberOfSamples());
-    query->setCurrentResolution(query->end_resolution);
-    return true;
-  }
+        //the last query merging the block releases it
+        if (--(*pending) == 0)
+          read_block->buffer = Array();
 
-  //execute with access
-  int bitsperblock = access->bitsperblock;
-  VisusAssert(bitsperblock);
+        done.set_value(Void());
+      });
+    }
+  });
+}
 
+///////////////////////////////////////////////////////////////////////////////////////
+std::vector<BigInt> IdxDataset::collectBoxQueryBlocks(BoxQuery* query, int bitsperblock)
+{
   FastLoopStack  item, * stack = NULL;
   FastLoopStack  STACK[DatasetBitmaskMaxLen + 1];
 
@@ -1306,6 +1418,8 @@ bool IdxDataset::executeBoxQuery(SharedPtr<Access> access, SharedPtr<BoxQuery> q
     fldeltas[H] = H ? (hzorder.getLevelDelta(H)[bitmask[H]] >> 1) : 0;
 
   auto aborted = query->aborted;
+  int cur_resolution = query->getCurrentResolution();
+  int end_resolution = query->end_resolution;
 
 #define PUSH()  (*((stack)++))=(item)
 #define POP()   (item)=(*(--(stack)))
@@ -1316,7 +1430,7 @@ bool IdxDataset::executeBoxQuery(SharedPtr<Access> access, SharedPtr<BoxQuery> q
   for (int H = cur_resolution + 1; H <= end_resolution; H++)
   {
     if (aborted())
-      return false;
+      return std::vector<BigInt>();
 
     LogicSamples Lsamples = this->getLevelSamples(H);
     BoxNi box = Lsamples.alignBox(query->logic_samples.logic_box);
@@ -1375,94 +1489,418 @@ bool IdxDataset::executeBoxQuery(SharedPtr<Access> access, SharedPtr<BoxQuery> q
 #undef POP  
 #undef EMPTY 
 
-  if (aborted())
-    return false;
-
-  int NREAD = 0;
-  int NWRITE = 0;
-  WaitAsync< Future<Void> > async_read;
+  return blocks;
+}
 
-  //waitAllDone
-  auto  waitAsyncRead = [&]()
-  {
-    async_read.waitAllDone();
-    //PrintInfo("aysnc read",concatenate(NREAD, "/", blocks.size()),"...");
-  };
+///////////////////////////////////////////////////////////////////////////////////////
+SharedPtr<IdxBoxQueryPlan> IdxDataset::createBoxQueryPlan(BoxQuery* query, int bitsperblock, Int64 max_memory)
+{
+  auto ret = std::make_shared<IdxBoxQueryPlan>(max_memory);
+  ret->key = IdxBoxQueryPlan::getKey(idxfile.bitmask.toString(), query->logic_samples, query->getCurrentResolution(), query->getEndResolution(), bitsperblock);
+  ret->logic_box = query->logic_samples.logic_box;
+  ret->delta = query->logic_samples.delta;
+  ret->cur_resolution = query->getCurrentResolution();
+  ret->end_resolution = query->getEndResolution();
+  ret->bitsperblock = bitsperblock;
+  ret->blocks = collectBoxQueryBlocks(query, bitsperblock);
+
+  //incomplete
+  if (query->aborted())
+    return SharedPtr<IdxBoxQueryPlan>();
 
-  //PrintInfo("Executing query...");
+  return ret;
+}
 
-  //rehentrant call...(just to not close the file too soon)
-  bool bWasWriting = access->isWriting();
-  bool bWasReading = access->isReading();
+///////////////////////////////////////////////////////////////////////////////////////
+SharedPtr<IdxBoxQueryPlan> IdxDataset::getBoxQueryPlan(BoxQuery* query, int bitsperblock)
+{
+  auto cache = IdxBoxQueryPlanCache::getSingleton();
+  auto key = IdxBoxQueryPlan::getKey(idxfile.bitmask.toString(), query->logic_samples, query->getCurrentResolution(), query->getEndResolution(), bitsperblock);
 
-  if (bWriting)
-  {
-    if (!bWasWriting)
-      access->beginWrite();
-  }
-  else
+  if (cache)
   {
-    if (!bWasReading)
-      access->beginRead();
+    if (auto ret = cache->get(key))
+      return ret;
   }
 
-  for (auto blockid : blocks)
-  {
-    if (aborted())
-      break;
+  auto ret = createBoxQueryPlan(query, bitsperblock);
 
-    //flush previous
-    if (async_read.getNumRunning() > 1024)
-      waitAsyncRead();
+  if (ret && cache)
+    cache->put(ret);
 
-    auto read_block = createBlockQuery(blockid, field, time, 'r', aborted);
-    NREAD++;
+  return ret;
+}
 
-    if (bReading)
-    {
-      executeBlockQuery(access, read_block);
-      async_read.pushRunning(read_block->done).when_ready([this, query, read_block, aborted](Void)
-      {
-        //I don't care if the read fails...
-        if (!aborted() && read_block->ok())
-          mergeBoxQueryWithBlockQuery(query, read_block);
-      });
-    }
-    else
-    {
-      //need a lease... so that I can read/merge/write like in a transaction mode
-      access->acquireWriteLock(read_block);
+///////////////////////////////////////////////////////////////////////////////////////
+bool IdxDataset::executeBoxQuery(SharedPtr<Access> access, SharedPtr<BoxQuery> query)
+{
+  if (!query)
+    return false;
 
-      //need to read and wait the block
-      executeBlockQueryAndWait(access, read_block);
+  if (!(query->isRunning() && query->getCurrentResolution() < query->getEndResolution()))
+    return false;
+
+  if (query->aborted())
+  {
+    query->setFailed("query aborted");
+    return false;
+  }
+
+  //for 'r' queries I can postpone the allocation
+  if (query->mode == 'w' && !query->buffer)
+  {
+    query->setFailed("write buffer not set");
+    return false;
+  }
+
+  if (!access)
+    return executeBoxQueryOnServer(query);
+
+  VisusAssert(access);
+
+  bool bWriting = query->mode == 'w';
+  bool bReading = query->mode == 'r';
+
+  const Field& field = query->field;
+  double        time = query->time;
+
+  int cur_resolution = query->getCurrentResolution();
+  int end_resolution = query->end_resolution;
+
+  if (!query->allocateBufferIfNeeded())
+    return false;
+
+  //filter enabled... need to go level by level
+  if (auto filter = query->filter.dataset_filter)
+  {
+    VisusAssert(bReading);
+
+    //need to go level by level to rebuild the original data (top-down)
+    for (int H = cur_resolution + 1; H <= end_resolution; H++)
+    {
+      BoxNi adjusted_logic_box = adjustBoxQueryFilterBox(query.get(), filter.get(), query->filter.adjusted_logic_box, H);
+
+      auto Wquery = createBoxQuery(adjusted_logic_box, query->field, query->time, 'r', query->aborted);
+      Wquery->setResolutionRange(0, H);
+      Wquery->disableFilters();
+
+      beginBoxQuery(Wquery);
+
+      //cannot get samples yet
+      if (!Wquery->isRunning())
+      {
+        VisusAssert(cur_resolution == -1);
+        VisusAssert(!query->filter.query);
+        continue;
+      }
+
+      //try to merge previous results
+      if (auto Rquery = query->filter.query)
+      {
+        if (!Wquery->allocateBufferIfNeeded())
+          return false;
+
+        //interpolate samples seems to be wrong here, produces a lot of artifacts (see david_wavelets)! 
+        //could be that I'm inserting wrong coefficients?
+        //for now insertSamples seems to work just fine, "interpolating" missing blocks/samples
+        if (!insertSamples(Wquery->logic_samples, Wquery->buffer, Rquery->logic_samples, Rquery->buffer, Wquery->aborted))
+          return false;
+
+        //note: start_resolution/end_resolution do not change
+        Wquery->setCurrentResolution(Rquery->getCurrentResolution());
+      }
+
+      if (!this->executeBoxQuery(access, Wquery))
+        return false;
+
+      filter->internalComputeFilter(Wquery.get(), /*bInverse*/true);
+
+      query->filter.query = Wquery;
+    }
+
+    //cannot get samples yet... returning failed as a query without filters...
+    if (!query->filter.query)
+    {
+      VisusAssert(false);//technically this should not happen since the outside query has got some samples
+      return false;
+    }
+
+    query->logic_samples = query->filter.query->logic_samples;
+    query->buffer = query->filter.query->buffer;
+
+    VisusAssert(query->buffer.dims == query->getNumberOfSamples());
+    query->setCurrentResolution(query->end_resolution);
+    return true;
+  }
+
+  //execute with access
+  int bitsperblock = access->bitsperblock;
+  VisusAssert(bitsperblock);
+
+  auto aborted = query->aborted;
+
+  //collect blocks (the same plan is reused by queries with the same logic samples and resolutions)
+  if (!query->plan || !query->plan->matches(query->logic_samples, query->getCurrentResolution(), query->getEndResolution(), bitsperblock))
+    query->plan = getBoxQueryPlan(query.get(), bitsperblock);
+  if (!query->plan)
+    return false;
+
+  std::vector<BigInt> blocks = query->plan->blocks;
+
+  //blocks known to be missing are not even scheduled
+  if (auto presence = bReading ? access->getBlockPresence(field, time) : SharedPtr< std::vector<bool> >())
+  {
+    std::vector<BigInt> present;
+    for (auto blockid : blocks)
+    {
+      if (blockid >= (BigInt)presence->size() || (*presence)[(size_t)blockid])
+        present.push_back(blockid);
+    }
+    blocks = present;
+  }
+
+  if (aborted())
+    return false;
+
+  int NREAD = 0;
+  int NWRITE = 0;
+  WaitAsync< Future<Void> > async_read;
+
+  //waitAllDone
+  auto  waitAsyncRead = [&]()
+  {
+    async_read.waitAllDone();
+    //PrintInfo("aysnc read",concatenate(NREAD, "/", blocks.size()),"...");
+  };
+
+  //PrintInfo("Executing query...");
+
+  //rehentrant call...(just to not close the file too soon)
+  bool bWasWriting = access->isWriting();
+  bool bWasReading = access->isReading();
+
+  if (bWriting)
+  {
+    if (!bWasWriting)
+      access->beginWrite();
+  }
+  else
+  {
+    if (!bWasReading)
+      access->beginRead();
+  }
+
+  //reading with a value predicate: blocks that cannot contain values in the range are not read
+  //their samples are replaced by the block min or max, so they stay on the same side of the range (e.g. for isocontours)
+  auto block_ranges = bReading && query->value_range.enabled ? access->getBlockRanges(field, time) : Array();
+  if (block_ranges && block_ranges.dims[0] == 2 * field.dtype.ncomponents())
+  {
+    int C = query->value_range.component;
+    int ncomponents = field.dtype.ncomponents();
+    auto ranges = (const Float64*)block_ranges.c_ptr();
+    Array fill(PointNi(std::vector<Int64>({ 1 })), DTypes::FLOAT64.withNumberOfComponents(ncomponents));
+
+    std::vector<BigInt> needed;
+    for (auto blockid : blocks)
+    {
+      //do not return here, the access must be closed below
+      if (aborted())
+        break;
+
+      const Float64* range = blockid < (BigInt)block_ranges.dims[1] ? ranges + blockid * 2 * ncomponents : nullptr;
+      if (!range || C < 0 || C >= ncomponents || (range[2 * C + 0] <= query->value_range.to && range[2 * C + 1] >= query->value_range.from))
+      {
+        needed.push_back(blockid);
+        continue;
+      }
+
+      //never written
+      if (range[2 * C + 0] > range[2 * C + 1])
+        continue;
+
+      for (int I = 0; I < ncomponents; I++)
+        ((Float64*)fill.c_ptr())[I] = range[2 * I + 0];
+      ((Float64*)fill.c_ptr())[C] = range[2 * C + 1] < query->value_range.from ? range[2 * C + 1] : range[2 * C + 0];
+
+      auto sample = ArrayUtils::cast(fill, field.dtype);
+      auto pruned = createBlockQuery(blockid, field, time, 'r', aborted);
+      if (!sample || !pruned->allocateBufferIfNeeded())
+      {
+        needed.push_back(blockid);
+        continue;
+      }
+
+      //write the first sample, then keep doubling the filled part
+      auto ptr = pruned->buffer.c_ptr();
+      Int64 sample_size = sample.c_size(), tot = pruned->buffer.c_size();
+      memcpy(ptr, sample.c_ptr(), (size_t)std::min(sample_size, tot));
+      for (Int64 done = sample_size; done < tot; done *= 2)
+        memcpy(ptr + done, ptr, (size_t)std::min(done, tot - done));
+
+      mergeBoxQueryWithBlockQuery(query, pruned);
+      query->value_range.npruned++;
+    }
+    blocks = needed;
+  }
+
+  //reading: the access knows in advance what is going to be read (see readahead)
+  if (bReading && !blocks.empty())
+    access->prefetchBlocks(field, time, blocks);
+
+  //reading: with a merge thread pool (see IdxDiskAccess merge_nthreads) blocks are merged in parallel as soon as they are read
+  auto merge_tpool = bReading ? access->getMergeThreadPool() : SharedPtr<ThreadPool>();
+
+  //reading: blocks are submitted in batches, so that the access can sort/coalesce them
+  //up to two batches can be in flight, so with max_read_memory a batch takes at most half of it
+  int batch_size = 1024;
+  if (bReading && query->max_read_memory > 0)
+    batch_size = (int)std::max((Int64)1, std::min((Int64)batch_size, query->max_read_memory / (2 * field.dtype.getByteSize((Int64)1 << bitsperblock))));
+  for (int A = 0; bReading && A < (int)blocks.size(); A += batch_size)
+  {
+    if (aborted())
+      break;
+
+    //flush previous
+    if (async_read.getNumRunning() > batch_size)
+      waitAsyncRead();
+
+    std::vector< SharedPtr<BlockQuery> > read_blocks;
+    for (int I = A; I < std::min(A + batch_size, (int)blocks.size()); I++)
+    {
+      auto read_block = createBlockQuery(blocks[I], field, time, 'r', aborted);
+      NREAD++;
+      MergeBoxQueriesWithBlockQueryWhenReady(this, async_read, merge_tpool, { query }, read_block);
+      read_blocks.push_back(read_block);
+    }
+
+    executeBlockQuery(access, read_blocks);
+  }
+
+  //writing: leases, reads and writes are submitted in the serial order
+  //with a write thread pool (see IdxDiskAccess write_nthreads) blocks are merged in parallel and writes are not waited one by one
+  auto write_tpool = bWriting ? access->getWriteThreadPool() : SharedPtr<ThreadPool>();
+  const int write_batch_size = write_tpool ? 64 : 1;
+  WaitAsync< Future<Void> > async_write;
+  auto bWriteFailed = std::make_shared< std::atomic<bool> >(false);
+
+  for (int A = 0; bWriting && A < (int)blocks.size() && !(*bWriteFailed); A += write_batch_size)
+  {
+    if (aborted())
+      break;
+
+    //limit the number of blocks waiting to be written
+    if (async_write.getNumRunning() > 1024)
+      async_write.waitAllDone();
+
+    std::vector< std::pair< SharedPtr<BlockQuery>, SharedPtr<BlockQuery> > > batch;
+    for (int I = A; I < std::min(A + write_batch_size, (int)blocks.size()); I++)
+    {
+      auto read_block = createBlockQuery(blocks[I], field, time, 'r', aborted);
 
       //WRITE block
-      auto write_block = createBlockQuery(blockid, field, time, 'w', aborted);
+      auto write_block = createBlockQuery(blocks[I], field, time, 'w', aborted);
+
+      //if the query overwrites all the block samples there is no need to read it
+      bool bFullyCovered = BoxQueryCoversBlockQuery(query.get(), write_block.get(), bitsperblock);
+
+      //need a lease... so that I can read/merge/write like in a transaction mode
+      access->acquireWriteLock(read_block);
+
+      //need to read and wait the block
+      if (!bFullyCovered)
+      {
+        bool bRead = executeBlockQueryAndWait(access, read_block);
+        NREAD++;
+
+        //aborted while the read is in flight: the lease is released only when the read is done with the file
+        if (!bRead && aborted())
+        {
+          read_block->done.get();
+          access->releaseWriteLock(read_block);
+          break;
+        }
+      }
 
       //read ok
-      if (read_block->ok())
+      if (!bFullyCovered && read_block->ok())
         write_block->buffer = read_block->buffer;
       //I don't care if it fails... maybe does not exist
       else
         write_block->allocateBufferIfNeeded();
 
-      mergeBoxQueryWithBlockQuery(query, write_block);
+      batch.push_back(std::make_pair(read_block, write_block));
+    }
+
+    //aborted: nothing of the batch is merged or written
+    if (aborted())
+    {
+      for (auto it : batch)
+        access->releaseWriteLock(it.first);
+      break;
+    }
+
+    //merge (each block has its own buffer, so they can go in parallel)
+    if (write_tpool && batch.size() > 1)
+    {
+      WaitAsync< Future<Void> > async_merge;
+      for (auto it : batch)
+      {
+        auto write_block = it.second;
+        Promise<Void> merged;
+        async_merge.pushRunning(merged.get_future());
+        ThreadPool::push(write_tpool, [this, query, write_block, merged]() mutable {
+          mergeBoxQueryWithBlockQuery(query, write_block);
+          merged.set_value(Void());
+        });
+      }
+      async_merge.waitAllDone();
+    }
+    else
+    {
+      for (auto it : batch)
+        mergeBoxQueryWithBlockQuery(query, it.second);
+    }
+
+    //aborted while merging: the merge could be incomplete
+    if (aborted())
+    {
+      for (auto it : batch)
+        access->releaseWriteLock(it.first);
+      break;
+    }
 
-      //need to write and wait for the block
-      executeBlockQueryAndWait(access, write_block);
+    for (auto it : batch)
+    {
+      auto read_block = it.first;
+      auto write_block = it.second;
+
+      //need to write the block
+      executeBlockQuery(access, write_block);
+      async_write.pushRunning(write_block->done).when_ready([write_block, bWriteFailed](Void) {
+        if (write_block->failed())
+          *bWriteFailed = true;
+      });
       NWRITE++;
 
       //important! all writings are with a lease!
       access->releaseWriteLock(read_block);
 
-      if (aborted() || write_block->failed()) {
-        if (!bWasWriting)
-          access->endWrite();
-        return false;
-      }
+      //serial path: wait for the block
+      if (!write_tpool)
+        async_write.waitAllDone();
     }
   }
 
+  //all the writes must be done before reading bWriteFailed for the last time
+  async_write.waitAllDone();
+
+  if (bWriting && (aborted() || *bWriteFailed)) 
+  {
+    if (!bWasWriting)
+      access->endWrite();
+    return false;
+  }
+
   if (bWriting && !bWasWriting)
     access->endWrite();
 
@@ -1482,6 +1920,447 @@ bool IdxDataset::executeBoxQuery(SharedPtr<Access> access, SharedPtr<BoxQuery> q
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////////
+std::vector<Array> IdxDataset::executeBoxQuery(SharedPtr<Access> access, SharedPtr<BoxQuery> query, std::vector<Field> fields, std::vector<double> timesteps)
+{
+  if (!query || query->mode != 'r')
+    return std::vector<Array>();
+
+  if (!(query->isRunning() && query->getCurrentResolution() < query->getEndResolution()))
+    return std::vector<Array>();
+
+  auto aborted = query->aborted;
+  if (aborted())
+  {
+    query->setFailed("query aborted");
+    return std::vector<Array>();
+  }
+
+  if (fields.empty())
+    fields = { query->field };
+
+  if (timesteps.empty())
+    timesteps = { query->time };
+
+  //one query for each (time,field), they all share the same logic samples
+  std::vector< SharedPtr<BoxQuery> > queries;
+  bool bSinglePass = access ? true : false;
+  for (auto time : timesteps)
+  {
+    for (auto field : fields)
+    {
+      auto sub = createBoxQuery(query->logic_box, field, time, 'r', aborted);
+      sub->start_resolution = query->start_resolution;
+      sub->end_resolutions = { query->end_resolution };
+      sub->filter.enabled = query->filter.enabled;
+      sub->value_range = query->value_range;
+      beginBoxQuery(sub);
+
+      if (!sub->isRunning() || sub->logic_samples.logic_box != query->logic_samples.logic_box)
+      {
+        query->setFailed(sub->isRunning() ? "wrong logic samples" : sub->errormsg);
+        return std::vector<Array>();
+      }
+
+      //filters need to go level by level, value predicates are per (field,time)
+      if (sub->filter.dataset_filter || sub->value_range.enabled)
+        bSinglePass = false;
+
+      queries.push_back(sub);
+    }
+  }
+
+  //fallback: one query at a time
+  if (!bSinglePass)
+  {
+    std::vector<Array> ret;
+    for (auto sub : queries)
+    {
+      if (!executeBoxQuery(access, sub))
+      {
+        query->setFailed(sub->errormsg);
+        return std::vector<Array>();
+      }
+      query->value_range.npruned += sub->value_range.npruned;
+      ret.push_back(sub->buffer);
+    }
+    query->setCurrentResolution(query->end_resolution);
+    return ret;
+  }
+
+  for (auto sub : queries)
+  {
+    if (!sub->allocateBufferIfNeeded())
+    {
+      query->setFailed("cannot allocate buffer");
+      return std::vector<Array>();
+    }
+  }
+
+  //the kd-traversal is done only once, copy spans are shared too
+  int bitsperblock = access->bitsperblock;
+  VisusAssert(bitsperblock);
+  auto plan = getBoxQueryPlan(queries[0].get(), bitsperblock);
+  if (!plan)
+  {
+    query->setFailed("query aborted");
+    return std::vector<Array>();
+  }
+
+  for (auto sub : queries)
+    sub->plan = plan;
+
+  const auto& blocks = plan->blocks;
+
+  bool bWasReading = access->isReading();
+  if (!bWasReading)
+    access->beginRead();
+
+  WaitAsync< Future<Void> > async_read;
+  auto merge_tpool = access->getMergeThreadPool();
+
+  //blocks are submitted block-major, so all the fields of the same file (see IdxDiskAccess::readBlocks) are read while the file is open
+  const int batch_size = 1024;
+  for (int T = 0; T < (int)timesteps.size() && !aborted(); T++)
+  {
+    std::vector< SharedPtr<BoxQuery> > Tqueries(queries.begin() + T * fields.size(), queries.begin() + (T + 1) * fields.size());
+
+    //blocks known to be missing are not even scheduled
+    std::vector< SharedPtr< std::vector<bool> > > presence;
+    for (auto sub : Tqueries)
+      presence.push_back(access->getBlockPresence(sub->field, sub->time));
+
+    std::vector< std::vector<BigInt> > Tblocks(Tqueries.size());
+    std::vector< std::tuple<int, double, BigInt> > prefetch;
+    for (auto blockid : blocks)
+    {
+      for (int F = 0; F < (int)Tqueries.size(); F++)
+      {
+        if (presence[F] && blockid < (BigInt)presence[F]->size() && !(*presence[F])[(size_t)blockid])
+          continue;
+        Tblocks[F].push_back(blockid);
+        prefetch.push_back(std::make_tuple(F, timesteps[T], blockid));
+      }
+    }
+    access->prefetchBlocks(fields, prefetch);
+
+    std::vector<size_t> next(Tqueries.size(), 0);
+    std::vector< SharedPtr<BlockQuery> > read_blocks;
+    for (auto blockid : blocks)
+    {
+      if (aborted())
+        break;
+
+      for (int F = 0; F < (int)Tqueries.size(); F++)
+      {
+        auto sub = Tqueries[F];
+        if (next[F] >= Tblocks[F].size() || Tblocks[F][next[F]] != blockid)
+          continue;
+        next[F]++;
+
+        auto read_block = createBlockQuery(blockid, sub->field, sub->time, 'r', aborted);
+        MergeBoxQueriesWithBlockQueryWhenReady(this, async_read, merge_tpool, { sub }, read_block);
+        read_blocks.push_back(read_block);
+      }
+
+      if (read_blocks.size() >= batch_size)
+      {
+        executeBlockQuery(access, read_blocks);
+        read_blocks.clear();
+
+        //flush previous
+        if (async_read.getNumRunning() > 2 * batch_size)
+          async_read.waitAllDone();
+      }
+    }
+
+    if (!read_blocks.empty())
+      executeBlockQuery(access, read_blocks);
+  }
+
+  if (!bWasReading)
+    access->endRead();
+
+  async_read.waitAllDone();
+
+  if (aborted())
+  {
+    query->setFailed("query aborted");
+    return std::vector<Array>();
+  }
+
+  std::vector<Array> ret;
+  for (auto sub : queries)
+  {
+    VisusAssert(sub->buffer.dims == sub->getNumberOfSamples());
+    sub->setCurrentResolution(sub->end_resolution);
+    ret.push_back(sub->buffer);
+  }
+
+  query->setCurrentResolution(query->end_resolution);
+  return ret;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+std::vector<BoxQueryCost> IdxDataset::estimateBoxQueryCost(SharedPtr<BoxQuery> query, SharedPtr<Access> access)
+{
+  std::vector<BoxQueryCost> ret;
+  if (!query)
+    return ret;
+
+  auto end_resolutions = query->end_resolutions;
+  if (end_resolutions.empty())
+  {
+    for (int H = query->start_resolution; H <= getMaxResolution(); H++)
+      end_resolutions.push_back(H);
+  }
+
+  int bitsperblock = access ? access->bitsperblock : getDefaultBitsPerBlock();
+  VisusAssert(bitsperblock);
+
+  auto field = getField(query->field.name);
+  if (!field.valid())
+    field = query->field;
+
+  Int64 block_bytes = field.dtype.getByteSize((Int64)1 << bitsperblock);
+
+  SharedPtr< std::vector<bool> > presence;
+  for (auto end_resolution : end_resolutions)
+  {
+    //same logic samples and blocks of the real query
+    auto sub = createBoxQuery(query->logic_box, field, query->time, 'r', query->aborted);
+    sub->start_resolution = query->start_resolution == end_resolution ? end_resolution : 0;
+    sub->end_resolutions = { end_resolution };
+    sub->disableFilters();
+    beginBoxQuery(sub);
+
+    if (!sub->isRunning())
+      continue;
+
+    //a cached plan is reused, but an estimate does not fill the cache (the query may never run)
+    auto cache = IdxBoxQueryPlanCache::getSingleton();
+    auto plan = cache ? cache->peek(IdxBoxQueryPlan::getKey(idxfile.bitmask.toString(), sub->logic_samples, sub->getCurrentResolution(), sub->getEndResolution(), bitsperblock)) : SharedPtr<IdxBoxQueryPlan>();
+    if (!plan)
+      plan = createBoxQueryPlan(sub.get(), bitsperblock);
+    if (!plan)
+      break;
+
+    if (access && ret.empty())
+      presence = access->getBlockPresence(field, sub->time);
+
+    std::vector<BigInt> blocks;
+    for (auto blockid : plan->blocks)
+    {
+      if (!presence || blockid >= (BigInt)presence->size() || (*presence)[(size_t)blockid])
+        blocks.push_back(blockid);
+    }
+
+    BoxQueryCost cost;
+    cost.end_resolution = end_resolution;
+    cost.nsamples = sub->getNumberOfSamples();
+    cost.output_bytes = sub->getByteSize();
+    cost.nblocks = (Int64)blocks.size();
+    cost.decoded_bytes = cost.nblocks * block_bytes;
+
+    Int64 known_bytes = 0;
+    if (access)
+    {
+      for (auto size : access->getStoredBlockSizes(field, sub->time, blocks))
+      {
+        if (size < 0) continue;
+        cost.nblocks_known++;
+        known_bytes += size;
+      }
+    }
+
+    //the blocks whose size is unknown are assumed to compress like the known ones
+    Int64 nunknown = cost.nblocks - cost.nblocks_known;
+    cost.compressed_bytes = known_bytes + (cost.nblocks_known ? (Int64)((double)nunknown * known_bytes / cost.nblocks_known) : nunknown * block_bytes);
+
+    ret.push_back(cost);
+  }
+
+  return ret;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+bool IdxDataset::executeBoxQueries(SharedPtr<Access> access, std::vector< SharedPtr<BoxQuery> > queries)
+{
+  //queries that cannot share blocks are executed one at a time
+  //(filters need to go level by level, value predicates prune blocks per query)
+  std::vector< SharedPtr<BoxQuery> > shared;
+  bool bOk = true;
+  for (auto query : queries)
+  {
+    if (!query || !query->canExecute())
+      continue;
+
+    if (!access || query->mode != 'r' || query->filter.dataset_filter || query->value_range.enabled)
+    {
+      bOk = executeBoxQuery(access, query) && bOk;
+      continue;
+    }
+
+    if (query->aborted())
+    {
+      query->setFailed("query aborted");
+      bOk = false;
+      continue;
+    }
+
+    if (!query->allocateBufferIfNeeded())
+    {
+      query->setFailed("cannot allocate buffer");
+      bOk = false;
+      continue;
+    }
+
+    shared.push_back(query);
+  }
+
+  if (shared.empty())
+    return bOk;
+
+  int bitsperblock = access->bitsperblock;
+  VisusAssert(bitsperblock);
+
+  //union of the plans: (time,blockid,field) -> queries needing the block
+  //the order is block-major, so all the fields of the same file (see IdxDiskAccess::readBlocks) are read while the file is open
+  typedef std::tuple<double, BigInt, String> Key;
+  std::map<Key, std::vector< SharedPtr<BoxQuery> > > consumers;
+  std::map<String, Field> fields;
+  std::vector< SharedPtr<BoxQuery> > planned;
+  for (auto query : shared)
+  {
+    if (!query->plan || !query->plan->matches(query->logic_samples, query->getCurrentResolution(), query->getEndResolution(), bitsperblock))
+      query->plan = getBoxQueryPlan(query.get(), bitsperblock);
+
+    if (!query->plan)
+    {
+      query->setFailed(query->aborted() ? "query aborted" : "cannot create the box query plan");
+      bOk = false;
+      continue;
+    }
+
+    planned.push_back(query);
+    fields[query->field.name] = query->field;
+    for (auto blockid : query->plan->blocks)
+      consumers[Key(query->time, blockid, query->field.name)].push_back(query);
+  }
+
+  if (planned.empty())
+    return bOk;
+
+  //blocks known to be missing are not even scheduled
+  std::map< std::pair<double, String>, SharedPtr< std::vector<bool> > > presence;
+  for (auto it = consumers.begin(); it != consumers.end(); )
+  {
+    auto time = std::get<0>(it->first);
+    auto blockid = std::get<1>(it->first);
+    auto fieldname = std::get<2>(it->first);
+    auto key = std::make_pair(time, fieldname);
+    if (!presence.count(key))
+      presence[key] = access->getBlockPresence(fields[fieldname], time);
+    auto bitmap = presence[key];
+    if (bitmap && blockid < (BigInt)bitmap->size() && !(*bitmap)[(size_t)blockid])
+    {
+      it = consumers.erase(it);
+      continue;
+    }
+    ++it;
+  }
+
+  bool bWasReading = access->isReading();
+  if (!bWasReading)
+    access->beginRead();
+
+  //one plan in the read order
+  std::vector<Field> prefetch_fields;
+  std::map<String, int> prefetch_index;
+  std::vector< std::tuple<int, double, BigInt> > prefetch;
+  for (const auto& it : consumers)
+  {
+    auto fieldname = std::get<2>(it.first);
+    if (!prefetch_index.count(fieldname))
+    {
+      prefetch_index[fieldname] = (int)prefetch_fields.size();
+      prefetch_fields.push_back(fields[fieldname]);
+    }
+    prefetch.push_back(std::make_tuple(prefetch_index[fieldname], std::get<0>(it.first), std::get<1>(it.first)));
+  }
+  access->prefetchBlocks(prefetch_fields, prefetch);
+
+  WaitAsync< Future<Void> > async_read;
+  auto merge_tpool = access->getMergeThreadPool();
+
+  //the shared reads are aborted only when all the queries are aborted
+  Aborted aborted;
+  auto nrunning = std::make_shared< std::atomic<int> >((int)planned.size());
+  std::vector<int> callbacks;
+  for (auto query : planned)
+  {
+    callbacks.push_back(query->aborted.addCallback([nrunning, aborted]() mutable {
+      if (--(*nrunning) == 0)
+        aborted.setTrue();
+    }));
+  }
+
+  //each block is read and decoded once, then merged into all its queries
+  //(the block buffer is released as soon as the last query has merged it, see MergeBoxQueriesWithBlockQueryWhenReady)
+  const int batch_size = 1024;
+  std::vector< SharedPtr<BlockQuery> > read_blocks;
+  for (auto it : consumers)
+  {
+    if (aborted())
+      break;
+
+    auto time = std::get<0>(it.first);
+    auto blockid = std::get<1>(it.first);
+    auto fieldname = std::get<2>(it.first);
+
+    auto read_block = createBlockQuery(blockid, fields[fieldname], time, 'r', aborted);
+    MergeBoxQueriesWithBlockQueryWhenReady(this, async_read, merge_tpool, it.second, read_block);
+    read_blocks.push_back(read_block);
+
+    if (read_blocks.size() >= batch_size)
+    {
+      executeBlockQuery(access, read_blocks);
+      read_blocks.clear();
+
+      //flush previous
+      if (async_read.getNumRunning() > 2 * batch_size)
+        async_read.waitAllDone();
+    }
+  }
+
+  if (!read_blocks.empty())
+    executeBlockQuery(access, read_blocks);
+
+  if (!bWasReading)
+    access->endRead();
+
+  async_read.waitAllDone();
+
+  for (int I = 0; I < (int)planned.size(); I++)
+    planned[I]->aborted.removeCallback(callbacks[I]);
+
+  for (auto query : planned)
+  {
+    if (query->aborted())
+    {
+      query->setFailed("query aborted");
+      bOk = false;
+      continue;
+    }
+
+    VisusAssert(query->buffer.dims == query->getNumberOfSamples());
+    query->setCurrentResolution(query->end_resolution);
+  }
+
+  return bOk;
+}
+
+
 
 ////////////////////////////////////////////////////////////////////////////////
 class InterpolateOp
@@ -1553,6 +2432,31 @@ public:
 
 
 
+//////////////////////////////////////////////////////////////////////////////////////////
+bool IdxDataset::streamBoxQuery(SharedPtr<Access> access, SharedPtr<BoxQuery> query, PointNi tile_size, std::function<bool(BoxNi, Array)> callback, Int64 max_memory)
+{
+  if (!query || !query->isRunning())
+    return false;
+
+  if (!access)
+  {
+    query->setFailed("streaming needs an access");
+    return false;
+  }
+
+  IdxBoxQueryStream stream(this, access, query, tile_size, max_memory);
+  while (stream.next())
+  {
+    if (!callback(stream.getLogicBox(), stream.getBuffer()))
+    {
+      query->setFailed("stopped by the tile callback");
+      return false;
+    }
+  }
+
+  return query->ok();
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////
 void IdxDataset::nextBoxQuery(SharedPtr<BoxQuery> query)
 {
@@ -1694,21 +2598,86 @@ void IdxDataset::beginPointQuery(SharedPtr<PointQuery> query)
 
 
 /////////////////////////////////////////////////////////////////////////////////////////////
+//point of a point query: hz address and offset in the query buffer
+struct PointQueryHzAddress
+{
+  BigInt hz;
+  Int64  index;
+};
+
+//////////////////////////////////////////////////////////////////////////
+VISUS_IMPLEMENT_SINGLETON_CLASS(IdxPointQueryThreadPool)
+
+//////////////////////////////////////////////////////////////////////////
+IdxPointQueryThreadPool::IdxPointQueryThreadPool()
+{
+  this->tpool = std::make_shared<ThreadPool>("IdxDataset PointQuery", std::max(1, (int)std::thread::hardware_concurrency()));
+}
+
+//////////////////////////////////////////////////////////////////////////
+IdxPointQueryThreadPool::~IdxPointQueryThreadPool()
+{
+  tpool->waitAll();
+  tpool.reset();
+}
+
+//////////////////////////////////////////////////////////////////////////
+//LSD radix sort on the block id (i.e. bits [bitsperblock,bitsperblock+nbits) of the hz address), stable so each block keeps the query order
+static bool RadixSortPointQueryHzAddresses(SharedPtr<HeapMemory>& v, Int64 num, int bitsperblock, int nbits)
+{
+  const int RadixBits = 11;
+  const size_t RadixSize = ((size_t)1) << RadixBits;
+
+  SharedPtr<HeapMemory> tmp;
+  for (int shift = bitsperblock; shift < bitsperblock + nbits; shift += RadixBits)
+  {
+    auto src = (PointQueryHzAddress*)v->c_ptr();
+
+    std::vector<Int64> count(RadixSize + 1, 0);
+    for (Int64 I = 0; I < num; I++)
+      count[(size_t)((src[I].hz >> shift) & (RadixSize - 1)) + 1]++;
+
+    //all the same digit
+    if (std::find(count.begin(), count.end(), num) != count.end())
+      continue;
+
+    for (size_t I = 1; I <= RadixSize; I++)
+      count[I] += count[I - 1];
+
+    if (!tmp)
+    {
+      tmp = std::make_shared<HeapMemory>();
+      if (!tmp->resize(num * sizeof(PointQueryHzAddress), __FILE__, __LINE__))
+        return false;
+    }
+
+    auto dst = (PointQueryHzAddress*)tmp->c_ptr();
+    for (Int64 I = 0; I < num; I++)
+      dst[count[(size_t)((src[I].hz >> shift) & (RadixSize - 1))]++] = src[I];
+
+    std::swap(v, tmp);
+  }
+
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
 class InsertBlockQuerySamplesIntoPointQuery
 {
 public:
 
-  //operator()
+  //operator() (v[0..num) are the points of the block)
   template <class Sample>
-  bool execute(IdxDataset* vf, PointQuery* query, BlockQuery* block_query, PointNi depth_mask, std::vector< std::pair<int, int> > v, Aborted aborted)
+  bool execute(IdxDataset* vf, PointQuery* query, BlockQuery* block_query, int bitsperblock, PointNi depth_mask, const PointQueryHzAddress* v, Int64 num, Aborted aborted)
   {
     auto& Wbuffer = query->buffer;       auto write = GetSamples<Sample>(Wbuffer);
     auto& Rbuffer = block_query->buffer; auto read  = GetSamples<Sample>(Rbuffer);
 
     if (block_query->buffer.layout == "hzorder")
     {
-      for (auto& it : v)
-        write[it.first] = read[it.second];
+      BigInt mask = (((BigInt)1) << bitsperblock) - 1;
+      for (const auto* it = v; it != v + num; it++)
+        write[it->index] = read[it->hz & mask];
 
       return true;
     }
@@ -1722,12 +2691,12 @@ public:
       int pdim = vf->getPointDim();
       switch (pdim)
       {
-        #define OFFSET(I) (stride[I] * ((((points+it.first * pdim)[I] & depth_mask[I])-block_origin[I])>>block_shift[I]))
-        case 1: for (auto& it : v) write[it.first] = read[OFFSET(0)]; return true;
-        case 2: for (auto& it : v) write[it.first] = read[OFFSET(0) + OFFSET(1)]; return true;
-        case 3: for (auto& it : v) write[it.first] = read[OFFSET(0) + OFFSET(1) + OFFSET(2)]; return true;
-        case 4: for (auto& it : v) write[it.first] = read[OFFSET(0) + OFFSET(1) + OFFSET(2) + OFFSET(3)]; return true;
-        case 5: for (auto& it : v) write[it.first] = read[OFFSET(0) + OFFSET(1) + OFFSET(2) + OFFSET(3) + OFFSET(4)]; return true;
+        #define OFFSET(I) (stride[I] * ((((points+it->index * pdim)[I] & depth_mask[I])-block_origin[I])>>block_shift[I]))
+        case 1: for (const auto* it = v; it != v + num; it++) write[it->index] = read[OFFSET(0)]; return true;
+        case 2: for (const auto* it = v; it != v + num; it++) write[it->index] = read[OFFSET(0) + OFFSET(1)]; return true;
+        case 3: for (const auto* it = v; it != v + num; it++) write[it->index] = read[OFFSET(0) + OFFSET(1) + OFFSET(2)]; return true;
+        case 4: for (const auto* it = v; it != v + num; it++) write[it->index] = read[OFFSET(0) + OFFSET(1) + OFFSET(2) + OFFSET(3)]; return true;
+        case 5: for (const auto* it = v; it != v + num; it++) write[it->index] = read[OFFSET(0) + OFFSET(1) + OFFSET(2) + OFFSET(3) + OFFSET(4)]; return true;
         #undef OFFSET
       }
       VisusAssert(false);
@@ -1806,7 +2775,6 @@ bool IdxDataset::executePointQuery(SharedPtr<Access> access, SharedPtr<PointQuer
     auto hzorder = HzOrder(bitmask);
     auto depth_mask = hzorder.getLevelP2Included(query->end_resolution);
     auto bitsperblock = access->bitsperblock;
-    auto samplesperblock = 1 << bitsperblock;
 
     auto npoints = query->getNumberOfPoints();
     auto tot = npoints.innerProduct();
@@ -1840,11 +2808,7 @@ bool IdxDataset::executePointQuery(SharedPtr<Access> access, SharedPtr<PointQuer
     VisusAssert((Int64)query->points->c_size() == npoints.innerProduct() * sizeof(Int64) * 3);
 
 
-    //blockid-> (offset of query buffer, block offset)
-    std::map<BigInt, std::vector< std::pair<int, int> > > blocks;
-
     int pdim = this->getPointDim();
-    PointNi p(pdim);
 
     //if this is not available I use the slower conversion p->zaddress->Hz
     if (!this->hzaddress_conversion_pointquery)
@@ -1855,49 +2819,109 @@ bool IdxDataset::executePointQuery(SharedPtr<Access> access, SharedPtr<PointQuer
 #if defined(_DEBUG)
       VisusAssert(false);
 #endif
+    }
+
+    //(hz address, offset of query buffer) of all the points inside the bounds
+    //chunks are converted in parallel, each one writes at its own offset and is compacted later
+    auto hzaddresses = std::make_shared<HeapMemory>();
+    if (!hzaddresses->resize(tot * sizeof(PointQueryHzAddress), __FILE__, __LINE__))
+    {
+      query->setFailed("out of memory");
+      return false;
+    }
 
-      auto SRC = (Int64*)query->points->c_ptr();
-      BigInt hzaddress;
-      for (int N = 0; N < tot; N++, SRC += pdim)
+    const Int64 chunk_size = 64 * 1024;
+    Int64 nchunks = (tot + chunk_size - 1) / chunk_size;
+    std::vector<Int64> chunk_count((size_t)nchunks, 0);
+
+    auto convertChunk = [&](Int64 C)
+    {
+      if (aborted())
+        return;
+
+      PointNi p(pdim);
+      Int64 A = C * chunk_size, B = std::min(tot, A + chunk_size);
+      auto SRC = (Int64*)query->points->c_ptr() + A * pdim;
+      auto DST = (PointQueryHzAddress*)hzaddresses->c_ptr() + A;
+
+      if (!this->hzaddress_conversion_pointquery)
       {
-        if (aborted()) {
-          query->setFailed("query aborted");
-          return false;
+        for (Int64 N = A; N < B; N++, SRC += pdim)
+        {
+          if (pdim >= 1) { p[0] = SRC[0]; if (!(p[0] >= bounds.p1[0] && p[0] < bounds.p2[0])) continue; p[0] &= depth_mask[0]; }
+          if (pdim >= 2) { p[1] = SRC[1]; if (!(p[1] >= bounds.p1[1] && p[1] < bounds.p2[1])) continue; p[1] &= depth_mask[1]; }
+          if (pdim >= 3) { p[2] = SRC[2]; if (!(p[2] >= bounds.p1[2] && p[2] < bounds.p2[2])) continue; p[2] &= depth_mask[2]; }
+          if (pdim >= 4) { p[3] = SRC[3]; if (!(p[3] >= bounds.p1[3] && p[3] < bounds.p2[3])) continue; p[3] &= depth_mask[3]; }
+          if (pdim >= 5) { p[4] = SRC[4]; if (!(p[4] >= bounds.p1[4] && p[4] < bounds.p2[4])) continue; p[4] &= depth_mask[4]; }
+          DST->hz = hzorder.getAddress(p);
+          DST->index = N;
+          DST++;
+        }
+      }
+      //the conversion from point to Hz will be faster
+      else
+      {
+        BigInt zaddress = 0;
+        int    shift = 0;
+        const auto& loc = this->hzaddress_conversion_pointquery->loc;
+
+        for (Int64 N = A; N < B; N++, SRC += pdim)
+        {
+          if (pdim >= 1) { p[0] = SRC[0]; if (!(p[0] >= bounds.p1[0] && p[0] < bounds.p2[0])) continue; p[0] &= depth_mask[0]; shift = (loc[0][p[0]].second); zaddress = loc[0][p[0]].first; }
+          if (pdim >= 2) { p[1] = SRC[1]; if (!(p[1] >= bounds.p1[1] && p[1] < bounds.p2[1])) continue; p[1] &= depth_mask[1]; shift = std::min(shift, loc[1][p[1]].second); zaddress |= loc[1][p[1]].first; }
+          if (pdim >= 3) { p[2] = SRC[2]; if (!(p[2] >= bounds.p1[2] && p[2] < bounds.p2[2])) continue; p[2] &= depth_mask[2]; shift = std::min(shift, loc[2][p[2]].second); zaddress |= loc[2][p[2]].first; }
+          if (pdim >= 4) { p[3] = SRC[3]; if (!(p[3] >= bounds.p1[3] && p[3] < bounds.p2[3])) continue; p[3] &= depth_mask[3]; shift = std::min(shift, loc[3][p[3]].second); zaddress |= loc[3][p[3]].first; }
+          if (pdim >= 5) { p[4] = SRC[4]; if (!(p[4] >= bounds.p1[4] && p[4] < bounds.p2[4])) continue; p[4] &= depth_mask[4]; shift = std::min(shift, loc[4][p[4]].second); zaddress |= loc[4][p[4]].first; }
+          DST->hz = ((zaddress | last_bitmask) >> shift);
+          DST->index = N;
+          DST++;
         }
-        if (pdim >= 1) { p[0] = SRC[0]; if (!(p[0] >= bounds.p1[0] && p[0] < bounds.p2[0])) continue; p[0] &= depth_mask[0]; }
-        if (pdim >= 2) { p[1] = SRC[1]; if (!(p[1] >= bounds.p1[1] && p[1] < bounds.p2[1])) continue; p[1] &= depth_mask[1]; }
-        if (pdim >= 3) { p[2] = SRC[2]; if (!(p[2] >= bounds.p1[2] && p[2] < bounds.p2[2])) continue; p[2] &= depth_mask[2]; }
-        if (pdim >= 4) { p[3] = SRC[3]; if (!(p[3] >= bounds.p1[3] && p[3] < bounds.p2[3])) continue; p[3] &= depth_mask[3]; }
-        if (pdim >= 5) { p[4] = SRC[4]; if (!(p[4] >= bounds.p1[4] && p[4] < bounds.p2[4])) continue; p[4] &= depth_mask[4]; }
-        hzaddress = hzorder.getAddress(p);
-        blocks[hzaddress >> bitsperblock].push_back(std::make_pair(N, (int)(hzaddress % samplesperblock)));
       }
+
+      chunk_count[(size_t)C] = DST - ((PointQueryHzAddress*)hzaddresses->c_ptr() + A);
+    };
+
+    //own pool, so that the chunks do not wait behind the box query merges (see IdxDiskAccess merge_nthreads)
+    auto tpool = IdxPointQueryThreadPool::getSingleton() ? IdxPointQueryThreadPool::getSingleton()->get() : SharedPtr<ThreadPool>();
+    if (nchunks > 1 && tpool && std::thread::hardware_concurrency() > 1)
+    {
+      //shared by all the point queries, so wait only for my chunks
+      auto done = std::make_shared<Semaphore>();
+      for (Int64 C = 0; C < nchunks; C++)
+        ThreadPool::push(tpool, [&convertChunk, C, done]() { convertChunk(C); done->up(); });
+
+      for (Int64 C = 0; C < nchunks; C++)
+        done->down();
     }
-    //the conversion from point to Hz will be faster
     else
     {
-      BigInt zaddress;
-      int    shift;
-      auto   SRC = (Int64*)query->points->c_ptr();
-      auto   loc = this->hzaddress_conversion_pointquery->loc;
-      BigInt hzaddress;
+      for (Int64 C = 0; C < nchunks; C++)
+        convertChunk(C);
+    }
 
-      for (int N = 0; N < tot; N++, SRC += pdim)
-      {
-        if (aborted()) {
-          query->setFailed("query aborted");
-          return false;
-        }
-        if (pdim >= 1) { p[0] = SRC[0]; if (!(p[0] >= bounds.p1[0] && p[0] < bounds.p2[0])) continue; p[0] &= depth_mask[0]; shift = (loc[0][p[0]].second); zaddress = loc[0][p[0]].first; }
-        if (pdim >= 2) { p[1] = SRC[1]; if (!(p[1] >= bounds.p1[1] && p[1] < bounds.p2[1])) continue; p[1] &= depth_mask[1]; shift = std::min(shift, loc[1][p[1]].second); zaddress |= loc[1][p[1]].first; }
-        if (pdim >= 3) { p[2] = SRC[2]; if (!(p[2] >= bounds.p1[2] && p[2] < bounds.p2[2])) continue; p[2] &= depth_mask[2]; shift = std::min(shift, loc[2][p[2]].second); zaddress |= loc[2][p[2]].first; }
-        if (pdim >= 4) { p[3] = SRC[3]; if (!(p[3] >= bounds.p1[3] && p[3] < bounds.p2[3])) continue; p[3] &= depth_mask[3]; shift = std::min(shift, loc[3][p[3]].second); zaddress |= loc[3][p[3]].first; }
-        if (pdim >= 5) { p[4] = SRC[4]; if (!(p[4] >= bounds.p1[4] && p[4] < bounds.p2[4])) continue; p[4] &= depth_mask[4]; shift = std::min(shift, loc[4][p[4]].second); zaddress |= loc[4][p[4]].first; }
-        hzaddress = ((zaddress | last_bitmask) >> shift);
-        blocks[hzaddress >> bitsperblock].push_back(std::make_pair(N, int(hzaddress % samplesperblock)));
-      }
+    if (aborted()) {
+      query->setFailed("query aborted");
+      return false;
     }
 
+    //compact
+    Int64 num = 0;
+    for (Int64 C = 0; C < nchunks; C++)
+    {
+      auto A = C * chunk_size;
+      if (num != A)
+        memmove((PointQueryHzAddress*)hzaddresses->c_ptr() + num, (PointQueryHzAddress*)hzaddresses->c_ptr() + A, (size_t)chunk_count[(size_t)C] * sizeof(PointQueryHzAddress));
+      num += chunk_count[(size_t)C];
+    }
+
+    //bucketing: after the sort the points of the same block are contiguous
+    if (!RadixSortPointQueryHzAddresses(hzaddresses, num, bitsperblock, std::max(0, getMaxResolution() + 1 - bitsperblock)))
+    {
+      query->setFailed("out of memory");
+      return false;
+    }
+    auto sorted = (const PointQueryHzAddress*)hzaddresses->c_ptr();
+
     //do the for loop block aligned
     WaitAsync< Future<Void> > wait_async;
 
@@ -1906,19 +2930,20 @@ bool IdxDataset::executePointQuery(SharedPtr<Access> access, SharedPtr<PointQuer
     if (!bWasReading)
       access->beginRead();
 
-    for (auto it : blocks)
+    for (Int64 A = 0, B; A < num; A = B)
     {
-      auto blockid = it.first;
-      auto v = it.second;
+      auto blockid = sorted[A].hz >> bitsperblock;
+      for (B = A + 1; B < num && (sorted[B].hz >> bitsperblock) == blockid; B++) {}
+
       auto block_query = createBlockQuery(blockid, query->field, query->time, 'r', aborted);
       this->executeBlockQuery(access, block_query);
-      wait_async.pushRunning(block_query->done).when_ready([this, query, block_query, v, aborted, depth_mask](Void) {
+      wait_async.pushRunning(block_query->done).when_ready([this, query, block_query, hzaddresses, A, B, bitsperblock, aborted, depth_mask](Void) {
 
         if (aborted() || block_query->failed())
           return;
 
         InsertBlockQuerySamplesIntoPointQuery op;
-        NeedToCopySamples(op, query->field.dtype, this, query.get(), block_query.get(), depth_mask, v, aborted);
+        NeedToCopySamples(op, query->field.dtype, this, query.get(), block_query.get(), bitsperblock, depth_mask, (const PointQueryHzAddress*)hzaddresses->c_ptr() + A, B - A, aborted);
 
         if (aborted())
           return;
@@ -2263,7 +3288,11 @@ void IdxDataset::computeFilter(const Field& field, int window_size,bool bVerbose
   for (int D = 0; D < getPointDim(); D++)
     sliding_box[D] = window_size;
 
+  //full scan, do not pollute the page cache
   auto acess = createAccess();
+  if (auto disk = std::dynamic_pointer_cast<IdxDiskAccess>(acess))
+    disk->enableDirectIO();
+
   for (auto time : getTimesteps().asVector())
     computeFilter(filter, time, field, acess, sliding_box, bVerbose);
 }
@@ -56,6 +56,111 @@ For support : support@visus.net
 
 namespace Visus {
 
+VISUS_IMPLEMENT_SINGLETON_CLASS(IdxDiskAccessHeaderCache)
+
+//////////////////////////////////////////////////////////////////////////////
+void IdxDiskAccessHeaderCache::setMaxMemory(Int64 value)
+{
+  ScopedLock lock(this->lock);
+  this->max_memory = std::max((Int64)0, value);
+  while (!lru.empty() && used_memory > max_memory)
+    remove(index.find(lru.back()));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+Int64 IdxDiskAccessHeaderCache::getUsedMemory() const
+{
+  ScopedLock lock(const_cast<IdxDiskAccessHeaderCache*>(this)->lock);
+  return used_memory;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+SharedPtr<HeapMemory> IdxDiskAccessHeaderCache::get(String filename, String version)
+{
+  ScopedLock lock(this->lock);
+
+  auto it = index.find(filename);
+  if (it == index.end())
+  {
+    ++nmiss;
+    return SharedPtr<HeapMemory>();
+  }
+
+  //file changed on disk
+  if (version.empty() || it->second.version != version)
+  {
+    remove(it);
+    ++nmiss;
+    return SharedPtr<HeapMemory>();
+  }
+
+  lru.splice(lru.begin(), lru, it->second.lru);
+  ++nhit;
+  return it->second.headers;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+SharedPtr<HeapMemory> IdxDiskAccessHeaderCache::peek(String filename, String version) const
+{
+  ScopedLock lock(const_cast<IdxDiskAccessHeaderCache*>(this)->lock);
+  auto it = index.find(filename);
+  if (it == index.end() || version.empty() || it->second.version != version)
+    return SharedPtr<HeapMemory>();
+  return it->second.headers;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void IdxDiskAccessHeaderCache::put(String filename, String version, SharedPtr<HeapMemory> headers)
+{
+  ScopedLock lock(this->lock);
+
+  if (!headers || version.empty() || headers->c_size() > max_memory)
+    return;
+
+  auto it = index.find(filename);
+  if (it != index.end())
+    remove(it);
+
+  while (!lru.empty() && used_memory + headers->c_size() > max_memory)
+    remove(index.find(lru.back()));
+
+  lru.push_front(filename);
+
+  Cached cached;
+  cached.version = version;
+  cached.headers = headers;
+  cached.lru = lru.begin();
+  index[filename] = cached;
+  used_memory += headers->c_size();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void IdxDiskAccessHeaderCache::invalidate(String filename)
+{
+  ScopedLock lock(this->lock);
+  auto it = index.find(filename);
+  if (it != index.end())
+    remove(it);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void IdxDiskAccessHeaderCache::clear()
+{
+  ScopedLock lock(this->lock);
+  lru.clear();
+  index.clear();
+  used_memory = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void IdxDiskAccessHeaderCache::remove(std::map<String, Cached>::iterator it)
+{
+  VisusAssert(it != index.end());
+  used_memory -= it->second.headers->c_size();
+  lru.erase(it->second.lru);
+  index.erase(it);
+}
+
 
 //////////////////////////////////////////////////////////////////////////////
 static String GetFilenameV1234(const IdxFile& idxfile, String TimeTemplate, String FilenameTemplate, Field field, double time, BigInt blockid)
@@ -370,6 +475,18 @@ private:
       return false;
     }
 
+    //try to reuse the headers already decoded by some other instance
+    auto cache = IdxDiskAccessHeaderCache::getSingleton();
+    String version = cache ? FileUtils::getFileVersion(filename) : String();
+    if (auto cached = cache ? cache->get(filename, version) : SharedPtr<HeapMemory>())
+    {
+      if (cached->c_size() == this->headers.c_size())
+      {
+        memcpy(this->headers.c_ptr(), cached->c_ptr(), (size_t)this->headers.c_size());
+        return true;
+      }
+    }
+
     //read the headers
     if (!this->file.read(0, this->headers.c_size(), this->headers.c_ptr()))
     {
@@ -381,6 +498,9 @@ private:
     for (int I = 0, Tot = (int)this->headers.c_size() / (int)sizeof(Int32); I < Tot; I++)
       ptr[I] = ByteOrder::fromNetworkByteOrder(ptr[I]);
 
+    if (cache)
+      cache->put(filename, version, this->headers.clone());
+
     return true;
   }
 
@@ -478,46 +598,74 @@ public:
     if (bVerbose)
       PrintInfo("Block header contains the following: block_offset",block_offset,"block_size",block_size,"compression",compression,"layout",layout);
 
+    if (block_header.isConstant())
+      return fillConstantBlock(query, block_header);
+
     if (!block_offset || !block_size)
       return failed("the idx data seeems not stored in the file");
 
-    auto encoded = std::make_shared<HeapMemory>();
-    if (!encoded->resize(block_size, __FILE__, __LINE__))
-      return failed(cstring("cannot resize block block_size",block_size));
-
-    if (bVerbose)
-      PrintInfo("Reading buffer: read block_offset",block_offset,"encoded->c_size",encoded->c_size());
+    //memory mapped file: no copy at all (uncompressed blocks will point directly to the page cache)
+    auto encoded = file->map(block_offset, block_size);
+    if (!encoded)
+    {
+      encoded = std::make_shared<HeapMemory>();
+      if (!encoded->resize(block_size, __FILE__, __LINE__))
+        return failed(cstring("cannot resize block block_size",block_size));
 
-    if (aborted())
-      return failed("aborted");
+      if (bVerbose)
+        PrintInfo("Reading buffer: read block_offset",block_offset,"encoded->c_size",encoded->c_size());
 
-    if (!file->read(block_offset, encoded->c_size(), encoded->c_ptr()))
-      return failed("cannot read encoded buffer");
+      if (aborted())
+        return failed("aborted");
 
-    if (bVerbose)
-      PrintInfo("Decoding buffer");
+      if (!file->read(block_offset, encoded->c_size(), encoded->c_ptr()))
+        return failed("cannot read encoded buffer");
+    }
 
-    if (aborted())
-      return failed("aborted");
+    decodeBlock(query, block_header, encoded);
+  }
 
-    //TODO: noninterruptile
-    auto decoded = ArrayUtils::decodeArray(compression, query->getNumberOfSamples(), query->field.dtype, encoded);
-    if (!decoded)
-      return failed("cannot decode the data");
+  //readBlocks
+  virtual void readBlocks(std::vector< SharedPtr<BlockQuery> > queries) override
+  {
+    //memory mapped files have nothing to gain by coalescing
+    if (file->isMemoryMappingEnabled() || (!coalesce_max_size && !file->isIoUringEnabled()))
+      return Access::readBlocks(queries);
+
+    //group by file (blocks of the same file are read in offset order)
+    std::vector<String> filenames;
+    std::map<String, std::vector< SharedPtr<BlockQuery> > > groups;
+    for (auto query : queries)
+    {
+      auto filename = getFilename(query->field, query->time, query->blockid);
+      auto& group = groups[filename];
+      if (group.empty())
+        filenames.push_back(filename);
+      group.push_back(query);
+    }
 
-    decoded.layout = layout;
+    for (auto filename : filenames)
+      readBlocks(filename, groups[filename]);
+  }
 
-    VisusAssert(decoded.dims == query->getNumberOfSamples());
-    query->buffer = decoded;
+  //writeBlock
+  virtual void writeBlock(SharedPtr<BlockQuery> query) override
+  {
+    writeBlock(query, encodeBlock(query));
+  }
 
-    if (bVerbose)
-      PrintInfo("Read block",blockid,"from file",file->getFilename(),"ok");
+  //encodeBlock (does not touch the file, can run on any thread; constant blocks are encoded as an empty buffer)
+  SharedPtr<HeapMemory> encodeBlock(SharedPtr<BlockQuery> query) const 
+  {
+    int sample_size = bConstantBlocks ? getConstantSampleSize(query->field.dtype) : 0;
+    if (sample_size && query->buffer.heap->hasConstantSample(sample_size))
+      return std::make_shared<HeapMemory>();
 
-    owner->readOk(query);
+    return ArrayUtils::encodeArray(query->field.default_compression, query->buffer);
   }
 
-  //writeBlock
-  virtual void writeBlock(SharedPtr<BlockQuery> query) override
+  //writeBlock (with the block already encoded)
+  void writeBlock(SharedPtr<BlockQuery> query, SharedPtr<HeapMemory> encoded)
   {
     BigInt blockid = query->blockid;
 
@@ -550,8 +698,6 @@ public:
 
     //encode the data
     String compression = query->field.default_compression;
-    auto decoded = query->buffer;
-    auto encoded = ArrayUtils::encodeArray(compression, decoded);
     if (!encoded)
     {
       VisusAssert(false);
@@ -567,6 +713,18 @@ public:
     if (!openFile(filename, "rw"))
       return failed("cannot open file");
 
+    //constant block: only the header changes (the space of an old payload is reclaimed next time the file is opened)
+    if (!encoded->c_size())
+    {
+      block_header.setConstantSample(query->buffer.c_ptr(), getConstantSampleSize(query->field.dtype));
+      getBlockHeader(query->field, blockid) = block_header;
+
+      if (bVerbose)
+        PrintInfo("IdxDiskAccess::write blockid", blockid, "ok (constant)");
+
+      return owner->writeOk(query);
+    }
+
     BlockHeader existing = getBlockHeader(query->field,blockid);
 
     if (bool bCanOverWrite = (existing.getOffset() && existing.getSize()) && (block_header.getSize() <= existing.getSize()))
@@ -576,15 +734,15 @@ public:
     }
     else
     {
-      Int64 filesize = file->size();
+      Int64 offset = allocateExtent(block_header.getSize());
 
-      if (filesize <=0)
+      if (offset <=0)
       {
         VisusAssert(false);
-        return failed("Failed to write block, gotoEnd() failed");
+        return failed("Failed to write block, cannot allocate space");
       }
 
-      block_header.setOffset(filesize);
+      block_header.setOffset(offset);
     }
 
     VisusAssert(block_header.getSize() && block_header.getOffset());
@@ -657,6 +815,11 @@ private:
     FormatRowMajor = 0x10
   };
 
+  enum
+  {
+    ConstantBlock = 0x100 //all samples are equal, the sample is stored in suffix_* and there is no payload
+  };
+
   //___________________________________________
   class FileHeader
   {
@@ -683,13 +846,39 @@ private:
     Uint32  offset_high = 0;
     Uint32  size        = 0;
     Uint32  flags       = 0;
-    Uint32  suffix_0    = 0; //not used
-    Uint32  suffix_1    = 0; //not used
-    Uint32  suffix_2    = 0; //not used
-    Uint32  suffix_3    = 0; //not used
+    Uint32  suffix_0    = 0; //constant sample (if ConstantBlock)
+    Uint32  suffix_1    = 0;
+    Uint32  suffix_2    = 0;
+    Uint32  suffix_3    = 0;
 
   public:
 
+    //exists
+    bool exists() const {
+      return isConstant() || (getOffset() && getSize());
+    }
+
+    //isConstant
+    bool isConstant() const {
+      return (flags & ConstantBlock) ? true : false;
+    }
+
+    //getConstantSample
+    void getConstantSample(Uint8* sample, int sample_size) const {
+      VisusAssert(isConstant() && sample_size <= (int)sizeof(Uint32) * 4);
+      memcpy(sample, &suffix_0, sample_size);
+    }
+
+    //setConstantSample (no payload)
+    void setConstantSample(const Uint8* sample, int sample_size) {
+      VisusAssert(sample_size <= (int)sizeof(Uint32) * 4);
+      suffix_0 = suffix_1 = suffix_2 = suffix_3 = 0;
+      memcpy(&suffix_0, sample, sample_size);
+      flags |= ConstantBlock;
+      setOffset(0);
+      setSize(0);
+    }
+
     //getOffset
     Int64 getOffset() const {
       Uint64 ret = (Uint64(offset_high) << 32) | (Uint64(offset_low) << 0);
@@ -772,159 +961,757 @@ private:
   SharedPtr<File> file;
   int             mode=0;
 
-  //re-entrant file lock
-  std::map<String, int> file_locks;
+public:
 
-  //getBlockHeader
-  BlockHeader& getBlockHeader(Field& field, Int64 blockid) {
-    return block_headers[cint(field.index)*idxfile.blocksperfile + idxfile.getBlockPositionInFile(blockid)];
+  //for readBlocks (coalesce_max_size==0 means one read for each block)
+  Int64           coalesce_max_gap = 64 * 1024;
+  Int64           coalesce_max_size = 16 * 1024 * 1024;
+
+  //store blocks with all samples equal only in the header (NOTE: files written this way cannot be read by older versions)
+  bool            bConstantBlocks = false;
+
+  //getConstantSampleSize (0 if the dtype cannot be stored as constant block)
+  static int getConstantSampleSize(DType dtype) {
+    int bitsize = dtype.getBitSize();
+    return (bitsize % 8) == 0 && bitsize <= (int)sizeof(Uint32) * 4 * 8 ? bitsize / 8 : 0;
   }
 
-  //openFile
-  bool openFile(String filename, String file_mode)
-  {
-    VisusReleaseAssert(!file_mode.empty());
-    VisusReleaseAssert(file_mode=="rw" || file_mode=="r");
+  //enableIoUring (readBlocks keeps all the reads of a file in flight at the same time)
+  void enableIoUring(bool value) {
+    file->enableIoUring(value);
+  }
 
-    //useless code, already opened in the desired mode
-    if (filename == this->file->getFilename() && file_mode == this->file->getFileMode())
-      return true;
+  //enableMemoryMapping (read-only files are memory mapped and blocks are views of the mapping)
+  void enableMemoryMapping(bool value) {
+    file->enableMemoryMapping(value);
+  }
 
-    if (this->file->isOpen())
-      closeFile("need to openFile");
+  //enableDirectIO (for full scans, blocks do not go through the page cache)
+  void enableDirectIO(bool value) {
+    file->enableDirectIO(value);
+  }
 
-    if (bVerbose)
-      PrintInfo("Opening file",filename,"mode", file_mode);
+  //prefetchBlocks (only issues hints to the OS, nearby blocks of the same file are merged in one hint)
+  void prefetchBlocks(Field field, double time, const std::vector<BigInt>& blockids)
+  {
+    std::vector< std::pair<Int64, Int64> > extents;
 
-    //already exist
-    if (this->file->open(filename, file_mode))
+    auto flush = [&]()
     {
-      //read the headers
-      if (!this->file->read(0, this->headers.c_size(), this->headers.c_ptr()))
+      std::sort(extents.begin(), extents.end());
+      for (int A = 0, B; A < (int)extents.size(); A = B)
       {
-        closeFile("cannot read headers");
-        return false;
+        Int64 offset = extents[A].first, end = offset + extents[A].second;
+        for (B = A + 1; B < (int)extents.size() && extents[B].first <= end + coalesce_max_gap; B++)
+          end = std::max(end, extents[B].first + extents[B].second);
+        file->prefetch(offset, end - offset);
       }
+      extents.clear();
+    };
 
-      // network to host order
-      Uint32* ptr = (Uint32*)(this->headers.c_ptr());
-      for (int I = 0, Tot = (int)this->headers.c_size() / (int)sizeof(Uint32); I < Tot; I++)
-        ptr[I] = ByteOrder::fromNetworkByteOrder(ptr[I]);
+    String current;
+    bool bOpen = false;
+    for (auto blockid : blockids)
+    {
+      auto filename = getFilename(field, time, blockid);
+      if (filename != current)
+      {
+        flush();
+        current = filename;
+        bOpen = openFile(filename, "r");
+      }
 
-      return true;
-    }
+      if (!bOpen)
+        continue;
 
-    //cannot read the file
-    if (!StringUtils::contains(file_mode,"w"))
-    {
-      closeFile("Cannot open file(" + filename + ")");
-      return false;
+      const BlockHeader& block_header = getBlockHeader(field, blockid);
+      if (block_header.getOffset() && block_header.getSize())
+        extents.push_back(std::make_pair(block_header.getOffset(), (Int64)block_header.getSize()));
     }
+    flush();
+  }
 
-    //create a new file and fill up the headers
-    if (!this->file->createAndOpen(filename, "rw"))
+  //getStoredBlockSizes (only peeks the headers already in the cache, there is no I/O apart from one stat for each file)
+  virtual std::vector<Int64> getStoredBlockSizes(Field field, double time, const std::vector<BigInt>& blockids) override
+  {
+    std::vector<Int64> ret(blockids.size(), -1);
+
+    auto cache = IdxDiskAccessHeaderCache::getSingleton();
+    if (!cache)
+      return ret;
+
+    String current;
+    SharedPtr<HeapMemory> cached;
+    for (int I = 0; I < (int)blockids.size(); I++)
     {
-      //should not fail here!
-      VisusAssert(false);
-      closeFile("Cannot create file(" + filename + ")");
-      FileUtils::removeFile(filename);
-      return false;
+      auto filename = getFilename(field, time, blockids[I]);
+      if (filename != current)
+      {
+        current = filename;
+        cached = cache->peek(filename, FileUtils::getFileVersion(filename));
+        if (cached && cached->c_size() != this->headers.c_size())
+          cached.reset();
+      }
+
+      if (!cached)
+        continue;
+
+      auto block_headers = (const BlockHeader*)(cached->c_ptr() + sizeof(FileHeader));
+      const auto& block_header = block_headers[cint(field.index) * idxfile.blocksperfile + idxfile.getBlockPositionInFile(blockids[I])];
+      ret[I] = block_header.getOffset() ? (Int64)block_header.getSize() : 0;
     }
 
-    //write an empty header
-    this->headers.fill(0);
-    if (!this->file->write(0, this->headers.c_size(), this->headers.c_ptr()))
+    return ret;
+  }
+
+  //readHeaders (in host byte order, does not use the instance file handle/headers)
+  bool readHeaders(File& file, String filename, HeapMemory& headers) const
+  {
+    headers.resize(this->headers.c_size(), __FILE__, __LINE__);
+    if (!file.open(filename, "r") || !file.read(0, headers.c_size(), headers.c_ptr()))
     {
-      //should not fail here!
-      VisusAssert(false);
-      closeFile("Cannot write zero headers file(" + filename + ")");
-      FileUtils::removeFile(filename);
+      PrintInfo("Cannot read headers of", filename);
       return false;
     }
 
+    auto ptr = (Uint32*)(headers.c_ptr());
+    for (int I = 0, Tot = (int)headers.c_size() / (int)sizeof(Uint32); I < Tot; I++)
+      ptr[I] = ByteOrder::fromNetworkByteOrder(ptr[I]);
+
     return true;
   }
 
-  //closeFile
-  void closeFile(String reason)
+  //scanFile (sets the bits of the blocks stored in the file, one bitmap for each field)
+  bool scanFile(String filename, BigInt first_block, std::vector< SharedPtr<IdxBlockPresence::Bitmap> >& bitmaps) const
   {
-    if (!this->file->isOpen())
-      return;
-
-    if (bVerbose)
-      PrintInfo("Closing file",this->file->getFilename(),"file_mode",this->file->getFileMode(),"reason",reason);
+    File file;
+    HeapMemory headers;
+    if (!readHeaders(file, filename, headers))
+      return false;
 
-    //need to write the headers
-    if (this->file->canWrite())
+    auto block_headers = (const BlockHeader*)(headers.c_ptr() + sizeof(FileHeader));
+    Int64 interleaving = std::max(1, idxfile.block_interleaving);
+    for (int F = 0; F < (int)idxfile.fields.size(); F++)
     {
-      auto ptr = (Uint32*)(this->headers.c_ptr());
-      for (int I = 0, Tot = (int)this->headers.c_size() / (int)sizeof(Uint32); I < Tot; I++)
-        ptr[I] = ByteOrder::toNetworkByteOrder(ptr[I]);
-
-      if (!this->file->write(0, this->headers.c_size(), this->headers.c_ptr()))
+      auto& bitmap = *bitmaps[F];
+      for (int P = 0; P < idxfile.blocksperfile; P++)
       {
-        VisusAssert(false);
-        if (bVerbose)
-          PrintInfo("cannot write headers");
+        BigInt blockid = first_block + interleaving * P;
+        const auto& block_header = block_headers[F * idxfile.blocksperfile + P];
+        if (blockid < (BigInt)bitmap.size() && block_header.exists())
+          bitmap[(size_t)blockid] = true;
       }
     }
-
-    this->file->close();
+    return true;
   }
 
-};
+  //compactFile (does not use the instance file handle/headers, so it can run on any thread)
+  bool compactFile(String filename) const
+  {
+    //the whole file is read and written once, no need to keep it in the page cache
+    File src;
+    src.enableDirectIO();
+    HeapMemory headers;
+    if (!readHeaders(src, filename, headers))
+      return false;
 
+    auto block_headers = (BlockHeader*)(headers.c_ptr() + sizeof(FileHeader));
+    int  num_blocks = idxfile.blocksperfile * (int)idxfile.fields.size();
+    auto ptr = (Uint32*)(headers.c_ptr());
 
+    //new layout: field by field, each field in HZ order, no holes
+    std::vector<Int64> old_offset(num_blocks, 0);
+    Int64 offset = headers.c_size();
+    bool bAlreadyCompact = true;
+    for (int I = 0; I < num_blocks; I++)
+    {
+      auto& block_header = block_headers[I];
+      if (!block_header.getOffset() || !block_header.getSize())
+        continue;
+
+      old_offset[I] = block_header.getOffset();
+      bAlreadyCompact = bAlreadyCompact && old_offset[I] == offset;
+      block_header.setOffset(offset);
+      offset += block_header.getSize();
+    }
 
-////////////////////////////////////////////////////////////////////
-IdxDiskAccess::IdxDiskAccess(IdxDataset* dataset,IdxFile idxfile, StringTree config) 
-{
-  Url url = dataset->getUrl();
-  
-  //create if the file does not exist
-  if (config.hasAttribute("url"))
-  {
-    url = config.readString("url");
+    Int64 old_filesize = src.size();
+    if (bAlreadyCompact && old_filesize == offset)
+      return true;
 
-    if (!url.valid())
-      ThrowException(cstring("cannot use", url, "for IdxDiskAccess::create, reason wrong url"));
+    String tmp_filename = filename + ".compact";
+    FileUtils::removeFile(tmp_filename);
+    File dst;
+    dst.enableDirectIO();
+    if (!dst.createAndOpen(tmp_filename, "w"))
+    {
+      PrintInfo("Cannot create", tmp_filename);
+      return false;
+    }
 
-    PrintInfo("Trying to use", url, "as cache location...");
+    auto failed = [&](String reason) {
+      PrintInfo("Cannot compact", filename, reason);
+      dst.close();
+      FileUtils::removeFile(tmp_filename);
+      return false;
+    };
 
-    //can create the file if it does not exists, this is useful if you want
-    //to create a disk cache for remote datasets
-    if (url.isFile() && !FileUtils::existsFile(url.getPath()))
+    HeapMemory buffer;
+    for (int I = 0; I < num_blocks; I++)
     {
-      auto filename = Path(url.getPath()).toString();
-      auto new_idxfile = idxfile;
-      new_idxfile.version = 6;
-      new_idxfile.block_interleaving = 0;
-      new_idxfile.filename_template = new_idxfile.guessFilenameTemplate(filename);
-      new_idxfile.save(filename);
+      const auto& block_header = block_headers[I];
+      if (!old_offset[I])
+        continue;
+
+      if (!buffer.resize(block_header.getSize(), __FILE__, __LINE__) || !src.read(old_offset[I], buffer.c_size(), buffer.c_ptr()))
+        return failed("cannot read block");
+
+      if (!dst.write(block_header.getOffset(), buffer.c_size(), buffer.c_ptr()))
+        return failed("cannot write block");
     }
 
-    //need to load it again since it can be different 
-    idxfile.load(url.toString());
-  }
+    for (int I = 0, Tot = (int)headers.c_size() / (int)sizeof(Uint32); I < Tot; I++)
+      ptr[I] = ByteOrder::toNetworkByteOrder(ptr[I]);
 
-  VisusAssert(idxfile.version>=1 && idxfile.version<=6);
+    if (!dst.write(0, headers.c_size(), headers.c_ptr()))
+      return failed("cannot write headers");
 
-  this->name = config.readString("name", "IdxDiskAccess");
-  this->idxfile = idxfile;
-  this->can_read  = StringUtils::find(config.readString("chmod", DefaultChMod), "r") >= 0;
-  this->can_write = StringUtils::find(config.readString("chmod", DefaultChMod), "w") >= 0;
-  this->bitsperblock = idxfile.bitsperblock;
-  this->bVerbose = config.readInt("verbose", 0);
+    src.close();
+    dst.close();
 
-  //special case, a "./" at the beginning means a reference to the url
-  auto resoveAlias = [&](String value) {
+    if (!FileUtils::moveFile(tmp_filename, filename))
+    {
+      //windows cannot rename over an existing file
+      FileUtils::removeFile(filename);
+      if (!FileUtils::moveFile(tmp_filename, filename))
+        return failed("cannot rename");
+    }
 
-    String dir = Path(url.getPath()).getParent().toString();
-    if (dir.empty())
-      return value;
+    if (auto cache = IdxDiskAccessHeaderCache::getSingleton())
+      cache->invalidate(filename);
 
-    if (StringUtils::startsWith(value, "./"))
-      value = StringUtils::replaceFirst(value, ".", dir);
+    if (bVerbose)
+      PrintInfo("Compacted", filename, "from", old_filesize, "to", offset);
+
+    return true;
+  }
+
+private:
+
+  //re-entrant file lock
+  std::map<String, int> file_locks;
+
+  //free extents (offset->size) of the file opened for writing, and where to append
+  //NOTE: space released during this session is not reused until the file is opened again, since the headers on disk still point to it
+  std::map<Int64, Int64> free_extents;
+  Int64                  append_offset = 0;
+
+  //buildFreeExtents (the holes are whatever is not referenced by any block header)
+  void buildFreeExtents()
+  {
+    std::vector< std::pair<Int64, Int64> > used;
+    for (int I = 0, Tot = idxfile.blocksperfile * (int)idxfile.fields.size(); I < Tot; I++)
+    {
+      const auto& block_header = block_headers[I];
+      if (block_header.getOffset() && block_header.getSize())
+        used.push_back(std::make_pair(block_header.getOffset(), (Int64)block_header.getSize()));
+    }
+    std::sort(used.begin(), used.end());
+
+    free_extents.clear();
+    Int64 cursor = headers.c_size();
+    for (auto it : used)
+    {
+      if (it.first > cursor)
+        free_extents[cursor] = it.first - cursor;
+      cursor = std::max(cursor, it.first + it.second);
+    }
+
+    //any trailing garbage will be overwritten by the next append
+    append_offset = cursor;
+  }
+
+  //allocateExtent (best fit among the free extents, otherwise append)
+  Int64 allocateExtent(Int64 size)
+  {
+    auto best = free_extents.end();
+    for (auto it = free_extents.begin(); it != free_extents.end(); ++it)
+    {
+      if (it->second >= size && (best == free_extents.end() || it->second < best->second))
+      {
+        best = it;
+        if (best->second == size)
+          break;
+      }
+    }
+
+    if (best == free_extents.end())
+    {
+      Int64 ret = append_offset;
+      append_offset += size;
+      return ret;
+    }
+
+    Int64 ret = best->first, remaining = best->second - size;
+    free_extents.erase(best);
+    if (remaining > 0)
+      free_extents[ret + size] = remaining;
+    return ret;
+  }
+
+  //getBlockHeader
+  BlockHeader& getBlockHeader(Field& field, Int64 blockid) {
+    return block_headers[cint(field.index)*idxfile.blocksperfile + idxfile.getBlockPositionInFile(blockid)];
+  }
+
+  //fillConstantBlock (no payload to read or decode)
+  void fillConstantBlock(SharedPtr<BlockQuery> query, const BlockHeader& block_header)
+  {
+    int sample_size = getConstantSampleSize(query->field.dtype);
+    Array buffer;
+    if (!sample_size || !buffer.resize(query->getNumberOfSamples(), query->field.dtype, __FILE__, __LINE__))
+      return owner->readFailed(query);
+
+    //write the first sample, then keep doubling the filled part
+    auto ptr = buffer.c_ptr();
+    Int64 tot = buffer.c_size();
+    block_header.getConstantSample(ptr, sample_size);
+    for (Int64 done = sample_size; done < tot; done *= 2)
+      memcpy(ptr + done, ptr, (size_t)std::min(done, tot - done));
+
+    buffer.layout = block_header.getLayout();
+    query->buffer = buffer;
+
+    if (bVerbose)
+      PrintInfo("Read constant block", query->blockid, "ok");
+
+    owner->readOk(query);
+  }
+
+  //decodeBlock
+  void decodeBlock(SharedPtr<BlockQuery> query, const BlockHeader& block_header, SharedPtr<HeapMemory> encoded)
+  {
+    if (bVerbose)
+      PrintInfo("Decoding buffer");
+
+    if (query->aborted())
+      return owner->readFailed(query);
+
+    //TODO: noninterruptile
+    auto decoded = ArrayUtils::decodeArray(block_header.getCompression(), query->getNumberOfSamples(), query->field.dtype, encoded);
+    if (!decoded)
+    {
+      if (bVerbose)
+        PrintInfo("IdxDiskAccess::read blockid", query->blockid, "failed cannot decode the data");
+      return owner->readFailed(query);
+    }
+
+    decoded.layout = block_header.getLayout();
+
+    VisusAssert(decoded.dims == query->getNumberOfSamples());
+    query->buffer = decoded;
+
+    if (bVerbose)
+      PrintInfo("Read block", query->blockid, "from file", file->getFilename(), "ok");
+
+    owner->readOk(query);
+  }
+
+  //readBlocks (all blocks in the same file, one read call for each run of nearby blocks)
+  void readBlocks(String filename, std::vector< SharedPtr<BlockQuery> > queries)
+  {
+    auto failed = [&](SharedPtr<BlockQuery> query, String reason) {
+
+      if (bVerbose)
+        PrintInfo("IdxDiskAccess::read blockid", query->blockid, "failed ", reason);
+
+      return owner->readFailed(query);
+    };
+
+    if (!openFile(filename, this->mode == 'w' ? "rw" : "r"))
+    {
+      for (auto query : queries)
+        failed(query, "cannot open file");
+      return;
+    }
+
+    std::vector< std::pair<BlockHeader, SharedPtr<BlockQuery> > > blocks;
+    for (auto query : queries)
+    {
+      if (query->aborted())
+      {
+        failed(query, "aborted");
+        continue;
+      }
+
+      const BlockHeader& block_header = getBlockHeader(query->field, query->blockid);
+      if (block_header.isConstant())
+      {
+        fillConstantBlock(query, block_header);
+        continue;
+      }
+
+      if (!block_header.getOffset() || !block_header.getSize())
+      {
+        failed(query, "the idx data seeems not stored in the file");
+        continue;
+      }
+
+      blocks.push_back(std::make_pair(block_header, query));
+    }
+
+    std::sort(blocks.begin(), blocks.end(), [](const std::pair<BlockHeader, SharedPtr<BlockQuery> >& a, const std::pair<BlockHeader, SharedPtr<BlockQuery> >& b) {
+      return a.first.getOffset() < b.first.getOffset();
+    });
+
+    //split in runs of nearby blocks [A,B)
+    std::vector< std::pair<int, int> > runs;
+    Int64 max_gap = 0;
+    for (int A = 0, B = 0; A < (int)blocks.size(); A = B)
+    {
+      Int64 run_begin = blocks[A].first.getOffset();
+      Int64 run_end   = run_begin + blocks[A].first.getSize();
+      for (B = A + 1; B < (int)blocks.size(); B++)
+      {
+        Int64 offset = blocks[B].first.getOffset();
+        Int64 end    = offset + blocks[B].first.getSize();
+        if (offset < run_end || offset - run_end > coalesce_max_gap || end - run_begin > coalesce_max_size)
+          break;
+        max_gap = std::max(max_gap, offset - run_end);
+        run_end = end;
+      }
+      runs.push_back(std::make_pair(A, B));
+    }
+
+    //bytes between blocks of the same run are read and thrown away
+    //(this runs on the async threads, so no exceptions: without memory for the gap each block is read on its own)
+    HeapMemory gap;
+    if (max_gap > 0 && !gap.resize(max_gap, __FILE__, __LINE__))
+    {
+      runs.clear();
+      for (int I = 0; I < (int)blocks.size(); I++)
+        runs.push_back(std::make_pair(I, I + 1));
+    }
+
+    //one read request for each run
+    std::vector< SharedPtr<HeapMemory> > encoded(blocks.size());
+    std::vector<File::ReadRequest> requests;
+    std::vector<int> request_run;
+    for (int R = 0; R < (int)runs.size(); R++)
+    {
+      int A = runs[R].first, B = runs[R].second;
+      File::ReadRequest request;
+      request.pos = blocks[A].first.getOffset();
+      bool bAllocated = true;
+      for (int I = A; I < B; I++)
+      {
+        Int64 offset = blocks[I].first.getOffset();
+        Int64 cursor = I == A ? offset : blocks[I - 1].first.getOffset() + blocks[I - 1].first.getSize();
+        if (offset > cursor)
+          request.buffers.push_back(std::make_pair(offset - cursor, gap.c_ptr()));
+
+        encoded[I] = std::make_shared<HeapMemory>();
+        bAllocated = encoded[I]->resize(blocks[I].first.getSize(), __FILE__, __LINE__) && bAllocated;
+        request.buffers.push_back(std::make_pair(encoded[I]->c_size(), encoded[I]->c_ptr()));
+      }
+
+      if (!bAllocated)
+      {
+        for (int I = A; I < B; I++)
+          failed(blocks[I].second, "cannot resize block");
+        continue;
+      }
+
+      if (bVerbose)
+        PrintInfo("Reading", B - A, "blocks with one call offset", request.pos);
+
+      requests.push_back(request);
+      request_run.push_back(R);
+    }
+
+    //with io_uring all runs are in flight at the same time and each run is decoded as soon as it completes
+    file->readBatch(requests, [&](int index, bool ok)
+    {
+      auto run = runs[request_run[index]];
+      for (int I = run.first; I < run.second; I++)
+      {
+        if (ok)
+          decodeBlock(blocks[I].second, blocks[I].first, encoded[I]);
+        else
+          failed(blocks[I].second, "cannot read encoded buffer");
+
+        encoded[I].reset();
+      }
+    });
+  }
+
+  //openFile
+  bool openFile(String filename, String file_mode)
+  {
+    VisusReleaseAssert(!file_mode.empty());
+    VisusReleaseAssert(file_mode=="rw" || file_mode=="r");
+
+    //useless code, already opened in the desired mode
+    if (filename == this->file->getFilename() && file_mode == this->file->getFileMode())
+      return true;
+
+    if (this->file->isOpen())
+      closeFile("need to openFile");
+
+    if (bVerbose)
+      PrintInfo("Opening file",filename,"mode", file_mode);
+
+    //already exist
+    if (this->file->open(filename, file_mode))
+    {
+      //read-only files can reuse the headers already decoded by some other instance
+      auto cache = this->file->canWrite() ? nullptr : IdxDiskAccessHeaderCache::getSingleton();
+      String version = cache ? FileUtils::getFileVersion(filename) : String();
+      if (auto cached = cache ? cache->get(filename, version) : SharedPtr<HeapMemory>())
+      {
+        if (cached->c_size() == this->headers.c_size())
+        {
+          memcpy(this->headers.c_ptr(), cached->c_ptr(), (size_t)this->headers.c_size());
+          return true;
+        }
+      }
+
+      //read the headers
+      if (!this->file->read(0, this->headers.c_size(), this->headers.c_ptr()))
+      {
+        closeFile("cannot read headers");
+        return false;
+      }
+
+      // network to host order
+      Uint32* ptr = (Uint32*)(this->headers.c_ptr());
+      for (int I = 0, Tot = (int)this->headers.c_size() / (int)sizeof(Uint32); I < Tot; I++)
+        ptr[I] = ByteOrder::fromNetworkByteOrder(ptr[I]);
+
+      if (cache)
+        cache->put(filename, version, this->headers.clone());
+
+      if (this->file->canWrite())
+        buildFreeExtents();
+
+      return true;
+    }
+
+    //cannot read the file
+    if (!StringUtils::contains(file_mode,"w"))
+    {
+      closeFile("Cannot open file(" + filename + ")");
+      return false;
+    }
+
+    //create a new file and fill up the headers
+    if (!this->file->createAndOpen(filename, "rw"))
+    {
+      //should not fail here!
+      VisusAssert(false);
+      closeFile("Cannot create file(" + filename + ")");
+      FileUtils::removeFile(filename);
+      return false;
+    }
+
+    //write an empty header
+    this->headers.fill(0);
+    if (!this->file->write(0, this->headers.c_size(), this->headers.c_ptr()))
+    {
+      //should not fail here!
+      VisusAssert(false);
+      closeFile("Cannot write zero headers file(" + filename + ")");
+      FileUtils::removeFile(filename);
+      return false;
+    }
+
+    buildFreeExtents();
+    return true;
+  }
+
+  //closeFile
+  void closeFile(String reason)
+  {
+    if (!this->file->isOpen())
+      return;
+
+    if (bVerbose)
+      PrintInfo("Closing file",this->file->getFilename(),"file_mode",this->file->getFileMode(),"reason",reason);
+
+    //need to write the headers
+    if (this->file->canWrite())
+    {
+      auto ptr = (Uint32*)(this->headers.c_ptr());
+      for (int I = 0, Tot = (int)this->headers.c_size() / (int)sizeof(Uint32); I < Tot; I++)
+        ptr[I] = ByteOrder::toNetworkByteOrder(ptr[I]);
+
+      if (!this->file->write(0, this->headers.c_size(), this->headers.c_ptr()))
+      {
+        VisusAssert(false);
+        if (bVerbose)
+          PrintInfo("cannot write headers");
+      }
+
+      //any cached copy of the headers is now stale
+      if (auto cache = IdxDiskAccessHeaderCache::getSingleton())
+        cache->invalidate(this->file->getFilename());
+    }
+
+    this->file->close();
+    this->free_extents.clear();
+    this->append_offset = 0;
+  }
+
+};
+
+
+
+////////////////////////////////////////////////////////////////////
+class IdxDiskAccess::Readahead
+{
+public:
+
+  typedef std::tuple<int, double, BigInt> Block;
+
+  UniquePtr<IdxDiskAccessV6> access; //owned by the thread
+  SharedPtr<ThreadPool>      tpool;
+  CriticalSection            lock;
+  std::vector<Field>         fields;
+  std::vector<Block>         blocks;
+  std::map<Block, int>       position;
+  int                        issued = 0;
+  int                        consumed = 0;
+  int                        window = 0;
+  int                        max_window = 0;
+
+  //constructor
+  Readahead(IdxDiskAccessV6* access_, int max_window_) : access(access_), max_window(max_window_) {
+    this->window = std::min(16, max_window);
+    this->tpool = std::make_shared<ThreadPool>("IdxDiskAccess Readahead", 1);
+  }
+
+  //destructor
+  ~Readahead() {
+    tpool->waitAll();
+    tpool.reset();
+  }
+
+  //setPlan (blocks are (index in fields, time, blockid) in read order, the window is kept from the previous plan)
+  void setPlan(const std::vector<Field>& fields, const std::vector<Block>& blocks)
+  {
+    ScopedLock lock(this->lock);
+    this->fields = fields;
+    this->blocks = blocks;
+    this->position.clear();
+    for (int I = (int)blocks.size() - 1; I >= 0; I--)
+      this->position[blocks[I]] = I;
+    this->issued = 0;
+    this->consumed = 0;
+    topUp();
+  }
+
+  //onRead (if the reads went past what has been prefetched the window is too small)
+  void onRead(const std::vector< SharedPtr<BlockQuery> >& queries)
+  {
+    ScopedLock lock(this->lock);
+
+    bool bCaughtUp = false;
+    for (auto query : queries)
+    {
+      int F = 0;
+      while (F < (int)fields.size() && fields[F].name != query->field.name)
+        F++;
+
+      auto it = position.find(Block(F, query->time, query->blockid));
+      if (it == position.end())
+        continue;
+
+      bCaughtUp = bCaughtUp || it->second >= issued;
+      consumed = std::max(consumed, it->second + 1);
+    }
+
+    if (bCaughtUp)
+      window = std::min(2 * window, max_window);
+
+    topUp();
+  }
+
+private:
+
+  //topUp (must have the lock)
+  void topUp()
+  {
+    issued = std::max(issued, consumed);
+    int end = std::min((int)blocks.size(), consumed + window);
+    if (end <= issued)
+      return;
+
+    //one hint for each field and timestep, so that nearby blocks of the same file are merged
+    std::map< std::pair<int, double>, std::vector<BigInt> > hint;
+    for (int I = issued; I < end; I++)
+      hint[std::make_pair(std::get<0>(blocks[I]), std::get<1>(blocks[I]))].push_back(std::get<2>(blocks[I]));
+    issued = end;
+
+    auto fields = this->fields;
+    ThreadPool::push(tpool, [this, fields, hint]() {
+      access->beginIO('r');
+      for (const auto& it : hint)
+        access->prefetchBlocks(fields[it.first.first], it.first.second, it.second);
+      access->endIO();
+    });
+  }
+
+};
+
+////////////////////////////////////////////////////////////////////
+IdxDiskAccess::IdxDiskAccess(IdxDataset* dataset,IdxFile idxfile, StringTree config) : dataset(dataset)
+{
+  Url url = dataset->getUrl();
+  
+  //create if the file does not exist
+  if (config.hasAttribute("url"))
+  {
+    url = config.readString("url");
+
+    if (!url.valid())
+      ThrowException(cstring("cannot use", url, "for IdxDiskAccess::create, reason wrong url"));
+
+    PrintInfo("Trying to use", url, "as cache location...");
+
+    //can create the file if it does not exists, this is useful if you want
+    //to create a disk cache for remote datasets
+    if (url.isFile() && !FileUtils::existsFile(url.getPath()))
+    {
+      auto filename = Path(url.getPath()).toString();
+      auto new_idxfile = idxfile;
+      new_idxfile.version = 6;
+      new_idxfile.block_interleaving = 0;
+      new_idxfile.filename_template = new_idxfile.guessFilenameTemplate(filename);
+      new_idxfile.save(filename);
+    }
+
+    //need to load it again since it can be different 
+    idxfile.load(url.toString());
+  }
+
+  VisusAssert(idxfile.version>=1 && idxfile.version<=6);
+
+  this->name = config.readString("name", "IdxDiskAccess");
+  this->idxfile = idxfile;
+  this->can_read  = StringUtils::find(config.readString("chmod", DefaultChMod), "r") >= 0;
+  this->can_write = StringUtils::find(config.readString("chmod", DefaultChMod), "w") >= 0;
+  this->bitsperblock = idxfile.bitsperblock;
+  this->bVerbose = config.readInt("verbose", 0);
+
+  //special case, a "./" at the beginning means a reference to the url
+  auto resoveAlias = [&](String value) {
+
+    String dir = Path(url.getPath()).getParent().toString();
+    if (dir.empty())
+      return value;
+
+    if (StringUtils::startsWith(value, "./"))
+      value = StringUtils::replaceFirst(value, ".", dir);
 
     value = StringUtils::replaceAll(value, "$(CurrentFileDirectory)", dir);
     return value;
@@ -933,12 +1720,25 @@ IdxDiskAccess::IdxDiskAccess(IdxDataset* dataset,IdxFile idxfile, StringTree con
   auto createAccess = [&]()->Access*{
     if (idxfile.version < 6)
       return new IdxDiskAccessV5(this, idxfile, resoveAlias(idxfile.time_template), resoveAlias(idxfile.filename_template), bVerbose);
+
+    auto ret = new IdxDiskAccessV6(this, idxfile, resoveAlias(idxfile.time_template), resoveAlias(idxfile.filename_template), bVerbose);
+    if (config.readBool("coalesce_reads", true))
+    {
+      ret->coalesce_max_gap  = StringUtils::getByteSizeFromString(config.readString("coalesce_max_gap", "64kb"));
+      ret->coalesce_max_size = StringUtils::getByteSizeFromString(config.readString("coalesce_max_size", "16mb"));
+    }
     else
-      return new IdxDiskAccessV6(this, idxfile, resoveAlias(idxfile.time_template), resoveAlias(idxfile.filename_template), bVerbose);
+    {
+      ret->coalesce_max_size = 0;
+    }
+    ret->enableIoUring(config.readBool("io_uring", false));
+    ret->enableMemoryMapping(config.readBool("mmap", false));
+    ret->bConstantBlocks = config.readBool("constant_blocks", false);
+    ret->enableDirectIO(config.readBool("direct_io", false));
+    return ret;
   };
 
-  this-> sync.reset(createAccess());
-  this->async.reset(createAccess());
+  this->sync.reset(createAccess());
 
   //set this only if you know what you are doing (example visus convert with only one process)
   this->bDisableWriteLocks = 
@@ -951,17 +1751,60 @@ IdxDiskAccess::IdxDiskAccess(IdxDataset* dataset,IdxFile idxfile, StringTree con
   //if (this->bDisableWriteLocks)
   //  PrintInfo("IdxDiskAccess::IdxDiskAccess disabling write locsk. be careful");
 
-  // important!number of threads must be <=1 
-#if 1
+  // important! each worker owns its own V5/V6 instance (i.e. file handle and headers) and must have only one thread
   bool disable_async = config.readBool("disable_async", dataset->isServerMode());
-  if (int nthreads = disable_async ? 0 : 1)
+  if (int nthreads = disable_async ? 0 : std::max(1, config.readInt("nthreads", 1)))
+  {
+    for (int I = 0; I < nthreads; I++)
+    {
+      this->async.push_back(UniquePtr<Access>(createAccess()));
+      this->async_tpool.push_back(std::make_shared<ThreadPool>("IdxDiskAccess Thread " + cstring(I), 1));
+    }
+
+    //limit the number of outstanding reads (0 means no limit)
+    this->max_inflight = std::max(0, config.readInt("max_inflight", 0));
+    for (int I = 0; I < max_inflight; I++)
+      this->inflight.up();
+  }
+
+  //block presence sidecar (if it does not exist it can be created with scanBlockPresence)
+  //loaded on first use; writers always keep it up to date, block_presence="false" only stops the reads from using it
+  if (idxfile.version >= 6 && url.isFile())
+  {
+    this->presence = std::make_shared<IdxBlockPresence>(IdxBlockPresence::getDefaultFilename(Path(url.getPath()).toString()));
+    this->bUsePresence = config.readBool("block_presence", true);
+  }
+
+  //block ranges sidecar (if it does not exist it can be created with scanBlockRanges)
+  //loaded on first use; writers always keep it up to date, block_ranges="false" only stops the reads from using it
+  if (url.isFile())
+  {
+    this->ranges = std::make_shared<IdxBlockRanges>(IdxBlockRanges::getDefaultFilename(Path(url.getPath()).toString()));
+    this->bUseRanges = config.readBool("block_ranges", true);
+  }
+
+  //readahead: up to readahead blocks of the plan given by prefetchBlocks are hinted to the OS ahead of the reads (0 means disabled)
+  if (int readahead = idxfile.version >= 6 ? std::max(0, config.readInt("readahead", 0)) : 0)
+  {
+    auto access = (IdxDiskAccessV6*)createAccess();
+    access->enableIoUring(false);
+    access->enableMemoryMapping(false);
+    this->readahead.reset(new Readahead(access, readahead));
+  }
+
+  //write pipeline: blocks are encoded on write_nthreads threads, while a single writer thread does all the file operations in the submission order
+  if (int write_nthreads = idxfile.version >= 6 ? std::max(0, config.readInt("write_nthreads", 0)) : 0)
   {
-    async_tpool = std::make_shared<ThreadPool>("IdxDiskAccess Thread", nthreads);
+    this->encode_tpool = std::make_shared<ThreadPool>("IdxDiskAccess Encoder", write_nthreads);
+    this->write_tpool = std::make_shared<ThreadPool>("IdxDiskAccess Writer", 1);
   }
-#endif
+
+  //read merges: blocks are merged into the box query buffer on merge_nthreads threads, instead of by the thread waiting for the reads
+  if (int merge_nthreads = std::max(0, config.readInt("merge_nthreads", 0)))
+    this->merge_tpool = std::make_shared<ThreadPool>("IdxDiskAccess Merger", merge_nthreads);
 
   if (bVerbose)
-    PrintInfo("IdxDiskAccess created url",url,"async",async_tpool?"yes":"no");
+    PrintInfo("IdxDiskAccess created url",url,"async",async_tpool.empty()? "no" : "yes","nthreads",async_tpool.size(),"max_inflight",max_inflight,"write_nthreads",encode_tpool? "yes" : "no","merge_nthreads",merge_tpool? "yes" : "no");
 }
 
 
@@ -976,11 +1819,24 @@ IdxDiskAccess::~IdxDiskAccess()
   if (bVerbose)
     PrintInfo("IdxDiskAccess destroyed");
 
-  if (async_tpool)
-  {
-    async_tpool->waitAll();
-    async_tpool.reset();
-  }
+  for (auto it : async_tpool)
+    it->waitAll();
+  async_tpool.clear();
+
+  if (write_tpool)
+    write_tpool->waitAll();
+  write_tpool.reset();
+  encode_tpool.reset();
+
+  if (merge_tpool)
+    merge_tpool->waitAll();
+  merge_tpool.reset();
+
+  readahead.reset();
+
+  //deferred updates of a writer that did not flush them
+  if (!isWriting())
+    flushBlockSidecarUpdates();
 
   //scrgiorgio: I have a problem here, don't know why
   //VisusReleaseAssert(!isReading() && !isWriting());
@@ -989,10 +1845,23 @@ IdxDiskAccess::~IdxDiskAccess()
 ////////////////////////////////////////////////////////////////////
 void IdxDiskAccess::disableAsync()
 {
-  async_tpool.reset();
+  async_tpool.clear();
 }
 
 
+////////////////////////////////////////////////////////////////////
+void IdxDiskAccess::enableDirectIO(bool value)
+{
+  if (auto v6 = dynamic_cast<IdxDiskAccessV6*>(sync.get()))
+    v6->enableDirectIO(value);
+
+  for (auto& it : async)
+  {
+    if (auto v6 = dynamic_cast<IdxDiskAccessV6*>(it.get()))
+      v6->enableDirectIO(value);
+  }
+}
+
 ////////////////////////////////////////////////////////////////////
 void IdxDiskAccess::disableWriteLock()
 {
@@ -1006,18 +1875,88 @@ String IdxDiskAccess::getFilename(Field field,double time,BigInt blockid) const
   return sync->getFilename(field, time, blockid);
 }
 
+////////////////////////////////////////////////////////////////////
+bool IdxDiskAccess::compact(int nthreads)
+{
+  auto v6 = dynamic_cast<IdxDiskAccessV6*>(sync.get());
+  if (!v6)
+  {
+    PrintInfo("IdxDiskAccess::compact supported only for version 6");
+    return false;
+  }
+
+  //the first block of each file (with block interleaving the first blocks are consecutive)
+  Int64  interleaving = std::max(1, idxfile.block_interleaving);
+  BigInt total_blocks = std::max(BigInt(1), (((BigInt)1) << idxfile.bitmask.getMaxResolution()) >> idxfile.bitsperblock);
+  std::vector<String> filenames;
+  std::set<String> unique;
+  for (auto time : idxfile.timesteps.asVector())
+  {
+    for (BigInt first = 0; first < total_blocks; first += interleaving * idxfile.blocksperfile)
+    {
+      for (BigInt blockid = first; blockid < first + interleaving && blockid < total_blocks; blockid++)
+      {
+        auto filename = getFilename(idxfile.fields[0], time, blockid);
+        if (unique.insert(filename).second && FileUtils::existsFile(filename))
+          filenames.push_back(filename);
+      }
+    }
+  }
+
+  auto tpool = nthreads > 0 ? std::make_shared<ThreadPool>("IdxDiskAccess Compact", nthreads) : SharedPtr<ThreadPool>();
+  std::atomic<int> nfailed(0);
+  for (auto filename : filenames)
+  {
+    ThreadPool::push(tpool, [this, v6, filename, &nfailed]() {
+
+      if (!bDisableWriteLocks)
+        FileUtils::lock(filename);
+
+      if (!v6->compactFile(filename))
+        ++nfailed;
+
+      if (!bDisableWriteLocks)
+        FileUtils::unlock(filename);
+    });
+  }
+
+  if (tpool)
+    tpool->waitAll();
+
+  PrintInfo("IdxDiskAccess::compact nfiles", filenames.size(), "nfailed", (int)nfailed);
+  return nfailed == 0;
+}
+
+////////////////////////////////////////////////////////////////////
+int IdxDiskAccess::getWorker(SharedPtr<BlockQuery> query) const
+{
+  //blocks of the same file always go to the same worker (so the file handle and the headers are reused)
+  //while blocks of different files can proceed in parallel
+  if (async.size() <= 1)
+    return 0;
+
+  auto filename = sync->getFilename(query->field, query->time, query->blockid);
+  return (int)(std::hash<String>()(filename) % async.size());
+}
+
 ////////////////////////////////////////////////////////////////////
 void IdxDiskAccess::beginIO(int mode) 
 {
-  if (async_tpool)
-    async_tpool->waitAll();
+  for (auto it : async_tpool)
+    it->waitAll();
+
+  if (write_tpool)
+    write_tpool->waitAll();
 
   Access::beginIO(mode);
-  if (!isWriting() && async_tpool)
+  if (!isWriting() && !async_tpool.empty())
   {
-    ThreadPool::push(async_tpool, [this, mode]() {
-      async->beginIO(mode);
-    });
+    for (int I = 0; I < (int)async_tpool.size(); I++)
+    {
+      ThreadPool::push(async_tpool[I], [this, I, mode]() {
+        async[I]->beginIO(mode);
+      });
+    }
   }
   else
   {
@@ -1028,24 +1967,57 @@ void IdxDiskAccess::beginIO(int mode)
 ////////////////////////////////////////////////////////////////////
 void IdxDiskAccess::endIO() 
 {
-  if (!isWriting() && async_tpool)
+  if (!isWriting() && !async_tpool.empty())
+  {
+    for (int I = 0; I < (int)async_tpool.size(); I++)
+    {
+      ThreadPool::push(async_tpool[I], [this, I]() {
+        async[I]->endIO();
+      });
+    }
+  }
+  else if (isWriting() && write_tpool)
   {
-    ThreadPool::push(async_tpool, [this]() {
-      async->endIO();
+    ThreadPool::push(write_tpool, [this]() {
+      sync->endIO();
     });
-    async_tpool->waitAll();
+    write_tpool->waitAll();
   }
   else
   {
     sync->endIO();
   }
 
-  if (async_tpool)
-    async_tpool->waitAll();
+  for (auto it : async_tpool)
+    it->waitAll();
+
+  //all blocks are on disk, now the readers can use the new bits
+  if (isWriting() && !bDeferSidecarUpdates)
+    flushBlockSidecarUpdates();
 
   Access::endIO();
 }
 
+////////////////////////////////////////////////////////////////////
+void IdxDiskAccess::flushBlockSidecarUpdates()
+{
+  if (presence)
+  {
+    ScopedLock lock(presence_lock);
+    for (auto it : presence_updates)
+      presence->endUpdate(it.first.first, it.first.second, it.second);
+    presence_updates.clear();
+  }
+
+  if (ranges)
+  {
+    ScopedLock lock(ranges_lock);
+    for (auto it : ranges_updates)
+      ranges->endUpdate(it.first.first, it.first.second, it.second);
+    ranges_updates.clear();
+  }
+}
+
 ////////////////////////////////////////////////////////////////////
 void IdxDiskAccess::readBlock(SharedPtr<BlockQuery> query)
 {
@@ -1065,10 +2037,27 @@ void IdxDiskAccess::readBlock(SharedPtr<BlockQuery> query)
     return readFailed(query);
   }
 
-  if (bool bAsync = !isWriting() && async_tpool)
+  if (readahead && !isWriting())
+    readahead->onRead({ query });
+
+  if (bool bAsync = !isWriting() && !async_tpool.empty())
+  {
+    int worker = getWorker(query);
+
+    if (max_inflight)
+      inflight.down();
+
+    ThreadPool::push(async_tpool[worker], [this, worker, query]() {
+      async[worker]->readBlock(query);
+      if (max_inflight)
+        inflight.up();
+    });
+  }
+  else if (isWriting() && write_tpool)
   {
-    ThreadPool::push(async_tpool, [this, query]() {
-      return async->readBlock(query);
+    //must go after all the pending writes
+    ThreadPool::push(write_tpool, [this, query]() {
+      sync->readBlock(query);
     });
   }
   else
@@ -1078,6 +2067,226 @@ void IdxDiskAccess::readBlock(SharedPtr<BlockQuery> query)
 }
 
 
+////////////////////////////////////////////////////////////////////
+void IdxDiskAccess::readBlocks(std::vector< SharedPtr<BlockQuery> > queries)
+{
+  VisusAssert(isReading());
+
+  bool bAsync = !isWriting() && !async_tpool.empty();
+
+  //one group for each worker
+  std::vector< std::vector< SharedPtr<BlockQuery> > > groups(bAsync ? async.size() : 1);
+  for (auto query : queries)
+  {
+    if (query->blockid < 0)
+    {
+      if (bVerbose)
+        PrintInfo("IdxDiskAccess::read blockid", query->blockid, "failed blockid is wrong", query->blockid);
+
+      readFailed(query);
+      continue;
+    }
+
+    groups[bAsync ? getWorker(query) : 0].push_back(query);
+  }
+
+  if (readahead && !isWriting())
+    readahead->onRead(queries);
+
+  if (!bAsync && isWriting() && write_tpool)
+  {
+    auto group = groups[0];
+    ThreadPool::push(write_tpool, [this, group]() {
+      sync->readBlocks(group);
+    });
+    return;
+  }
+
+  if (!bAsync)
+    return sync->readBlocks(groups[0]);
+
+  for (int worker = 0; worker < (int)groups.size(); worker++)
+  {
+    //each job cannot hold more than max_inflight tokens, otherwise it would wait forever
+    auto& group = groups[worker];
+    int chunk = max_inflight ? max_inflight : (int)group.size();
+    for (int A = 0; A < (int)group.size(); A += chunk)
+    {
+      auto job = std::vector< SharedPtr<BlockQuery> >(group.begin() + A, group.begin() + std::min(A + chunk, (int)group.size()));
+
+      for (int I = 0; max_inflight && I < (int)job.size(); I++)
+        inflight.down();
+
+      ThreadPool::push(async_tpool[worker], [this, worker, job]() {
+        async[worker]->readBlocks(job);
+        for (int I = 0; max_inflight && I < (int)job.size(); I++)
+          inflight.up();
+      });
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+SharedPtr< std::vector<bool> > IdxDiskAccess::getBlockPresence(Field field, double time)
+{
+  if (!presence || !bUsePresence)
+    return SharedPtr< std::vector<bool> >();
+
+  ScopedLock lock(presence_lock);
+  if (presence->needReload())
+    presence->load();
+
+  return presence->getBitmap(field.name, time);
+}
+
+////////////////////////////////////////////////////////////////////
+bool IdxDiskAccess::scanBlockPresence()
+{
+  auto v6 = dynamic_cast<IdxDiskAccessV6*>(sync.get());
+  if (!v6 || !presence)
+  {
+    PrintInfo("IdxDiskAccess::scanBlockPresence supported only for version 6 local datasets");
+    return false;
+  }
+
+  Int64  interleaving = std::max(1, idxfile.block_interleaving);
+  BigInt total_blocks = std::max(BigInt(1), (((BigInt)1) << idxfile.bitmask.getMaxResolution()) >> idxfile.bitsperblock);
+  if (total_blocks > (((BigInt)1) << 32))
+  {
+    PrintInfo("IdxDiskAccess::scanBlockPresence too many blocks", total_blocks);
+    return false;
+  }
+
+  std::map< std::pair<String, double>, SharedPtr<IdxBlockPresence::Bitmap> > bitmaps;
+  for (auto time : idxfile.timesteps.asVector())
+  {
+    std::vector< SharedPtr<IdxBlockPresence::Bitmap> > time_bitmaps;
+    for (auto field : idxfile.fields)
+    {
+      auto bitmap = std::make_shared<IdxBlockPresence::Bitmap>((size_t)total_blocks, false);
+      bitmaps[std::make_pair(field.name, time)] = bitmap;
+      time_bitmaps.push_back(bitmap);
+    }
+
+    for (BigInt first = 0; first < total_blocks; first += interleaving * idxfile.blocksperfile)
+    {
+      for (BigInt blockid = first; blockid < first + interleaving && blockid < total_blocks; blockid++)
+      {
+        auto filename = getFilename(idxfile.fields[0], time, blockid);
+        if (FileUtils::existsFile(filename))
+          v6->scanFile(filename, blockid, time_bitmaps);
+      }
+    }
+  }
+
+  ScopedLock lock(presence_lock);
+  FileUtils::lock(presence->getFilename());
+  presence->load();
+  for (auto it : bitmaps)
+    presence->setBitmap(it.first.first, it.first.second, it.second);
+  bool ret = presence->save();
+  FileUtils::unlock(presence->getFilename());
+  return ret;
+}
+
+////////////////////////////////////////////////////////////////////
+Array IdxDiskAccess::getBlockRanges(Field field, double time)
+{
+  if (!ranges || !bUseRanges)
+    return Array();
+
+  ScopedLock lock(ranges_lock);
+  if (ranges->needReload())
+    ranges->load();
+
+  return ranges->getRanges(field.name, time);
+}
+
+////////////////////////////////////////////////////////////////////
+bool IdxDiskAccess::scanBlockRanges()
+{
+  if (!ranges)
+  {
+    PrintInfo("IdxDiskAccess::scanBlockRanges supported only for local datasets");
+    return false;
+  }
+
+  BigInt total_blocks = std::max(BigInt(1), (((BigInt)1) << idxfile.bitmask.getMaxResolution()) >> idxfile.bitsperblock);
+  if (total_blocks > (((BigInt)1) << 32))
+  {
+    PrintInfo("IdxDiskAccess::scanBlockRanges too many blocks", total_blocks);
+    return false;
+  }
+
+  bool bWasReading = isReading();
+  if (!bWasReading)
+    beginRead();
+
+  std::map< std::pair<String, double>, Array > values;
+  for (auto time : idxfile.timesteps.asVector())
+  {
+    for (auto field : idxfile.fields)
+    {
+      auto presence = getBlockPresence(field, time);
+      auto field_ranges = IdxBlockRanges::createRanges(field.dtype.ncomponents(), total_blocks);
+      auto ptr = (Float64*)field_ranges.c_ptr();
+      for (BigInt blockid = 0; blockid < total_blocks; blockid++)
+      {
+        if (presence && blockid < (BigInt)presence->size() && !(*presence)[(size_t)blockid])
+          continue;
+
+        auto query = dataset->createBlockQuery(blockid, field, time, 'r');
+        readBlock(query);
+        query->done.get();
+        if (!query->ok())
+          continue;
+
+        auto value = IdxBlockRanges::computeRanges(query->buffer);
+        std::copy(value.begin(), value.end(), ptr + blockid * field_ranges.dims[0]);
+      }
+      values[std::make_pair(field.name, time)] = field_ranges;
+    }
+  }
+
+  if (!bWasReading)
+    endRead();
+
+  ScopedLock lock(ranges_lock);
+  FileUtils::lock(ranges->getFilename());
+  ranges->load();
+  for (auto it : values)
+    ranges->setRanges(it.first.first, it.first.second, it.second);
+  bool ret = ranges->save();
+  FileUtils::unlock(ranges->getFilename());
+  return ret;
+}
+
+////////////////////////////////////////////////////////////////////
+void IdxDiskAccess::prefetchBlocks(Field field, double time, const std::vector<BigInt>& blockids)
+{
+  if (!readahead || isWriting())
+    return;
+
+  std::vector< std::tuple<int, double, BigInt> > blocks;
+  blocks.reserve(blockids.size());
+  for (auto blockid : blockids)
+    blocks.push_back(std::make_tuple(0, time, blockid));
+  prefetchBlocks(std::vector<Field>({ field }), blocks);
+}
+
+////////////////////////////////////////////////////////////////////
+void IdxDiskAccess::prefetchBlocks(const std::vector<Field>& fields, const std::vector< std::tuple<int, double, BigInt> >& blocks)
+{
+  if (readahead && !isWriting())
+    readahead->setPlan(fields, blocks);
+}
+
+////////////////////////////////////////////////////////////////////
+std::vector<Int64> IdxDiskAccess::getStoredBlockSizes(Field field, double time, const std::vector<BigInt>& blockids)
+{
+  return sync->getStoredBlockSizes(field, time, blockids);
+}
+
 ////////////////////////////////////////////////////////////////////
 void IdxDiskAccess::writeBlock(SharedPtr<BlockQuery> query)
 {
@@ -1088,6 +2297,73 @@ void IdxDiskAccess::writeBlock(SharedPtr<BlockQuery> query)
   if (bVerbose)
     PrintInfo("got request to write block blockid",blockid);
 
+  //a new block: the readers must not trust the presence bitmap until endIO
+  if (presence && blockid >= 0)
+  {
+    ScopedLock lock(presence_lock);
+    auto key = std::make_pair(query->field.name, query->time);
+    auto it = presence_updates.find(key);
+    if (it != presence_updates.end())
+    {
+      it->second.push_back(blockid);
+    }
+    else
+    {
+      if (presence->needReload())
+        presence->load();
+
+      auto bitmap = presence->getBitmap(key.first, key.second, /*bEvenIfWriting*/true);
+      if (bitmap && blockid < (BigInt)bitmap->size() && !(*bitmap)[(size_t)blockid] && presence->beginUpdate(key.first, key.second))
+        presence_updates[key].push_back(blockid);
+    }
+  }
+
+  //the readers must not trust the old ranges until endIO
+  if (ranges && blockid >= 0)
+  {
+    ScopedLock lock(ranges_lock);
+    auto key = std::make_pair(query->field.name, query->time);
+    auto it = ranges_updates.find(key);
+    if (it == ranges_updates.end())
+    {
+      if (ranges->needReload())
+        ranges->load();
+
+      if (ranges->getRanges(key.first, key.second, /*bEvenIfWriting*/true) && ranges->beginUpdate(key.first, key.second))
+        it = ranges_updates.insert(std::make_pair(key, std::map<BigInt, std::vector<double> >())).first;
+    }
+
+    //lossy compression: the decoded samples can be outside the range of the written ones, so the block is never pruned (until scanBlockRanges, that uses decoded blocks)
+    if (it != ranges_updates.end())
+    {
+      auto encoder = Encoders::getSingleton()->createEncoder(query->field.default_compression);
+      it->second[blockid] = encoder && !encoder->isLossy() ? 
+        IdxBlockRanges::computeRanges(query->buffer) : 
+        IdxBlockRanges::unknownRanges(query->field.dtype.ncomponents());
+    }
+  }
+
+  if (write_tpool)
+  {
+    //encode in parallel...
+    Promise< SharedPtr<HeapMemory> > encoded;
+    auto encoder = dynamic_cast<IdxDiskAccessV6*>(sync.get());
+    VisusReleaseAssert(encoder);
+    ThreadPool::push(encode_tpool, [encoder, query, encoded]() mutable {
+      encoded.set_value(encoder->encodeBlock(query));
+    });
+
+    //...but write in the submission order, so the file layout is the same of the serial path
+    ThreadPool::push(write_tpool, [this, query, encoded]() mutable {
+      auto writer = dynamic_cast<IdxDiskAccessV6*>(sync.get());
+      VisusReleaseAssert(writer);
+      if (!bDisableWriteLocks) sync->acquireWriteLock(query);
+      writer->writeBlock(query, encoded.get_future().get());
+      if (!bDisableWriteLocks) sync->releaseWriteLock(query);
+    });
+    return;
+  }
+
   acquireWriteLock(query);
   sync->writeBlock(query);
   releaseWriteLock(query);
@@ -1099,6 +2375,15 @@ void IdxDiskAccess::acquireWriteLock(SharedPtr<BlockQuery> query)
 {
   VisusAssert(isWriting());
   if (bDisableWriteLocks) return;
+
+  if (write_tpool)
+  {
+    ThreadPool::push(write_tpool, [this, query]() {
+      sync->acquireWriteLock(query);
+    });
+    return;
+  }
+
   sync->acquireWriteLock(query);
 }
 
@@ -1107,6 +2392,15 @@ void IdxDiskAccess::releaseWriteLock(SharedPtr<BlockQuery> query)
 {
   if (bDisableWriteLocks) return;
   VisusAssert(isWriting());
+
+  if (write_tpool)
+  {
+    ThreadPool::push(write_tpool, [this, query]() {
+      sync->releaseWriteLock(query);
+    });
+    return;
+  }
+
   sync->releaseWriteLock(query);
 }
 
@@ -648,6 +648,56 @@ NetResponse ModVisus::handleBoxQuery(const NetRequest& request)
 }
 
 
+///////////////////////////////////////////////////////////////////////////
+NetResponse ModVisus::handleBoxQueryCost(const NetRequest& request)
+{
+  auto dataset_name = request.url.getParam("dataset");
+  auto time = cdouble(request.url.getParam("time"));
+  auto format = request.url.getParam("format", "json");
+
+  auto datasets = getDatasets();
+
+  auto dataset = datasets->findDataset(dataset_name);
+  if (!dataset)
+    return NetResponseError(HttpStatus::STATUS_NOT_FOUND, "Cannot find dataset(" + dataset_name + ")");
+
+  int pdim = dataset->getPointDim();
+
+  String fieldname = request.url.getParam("field");
+  Field field = fieldname.empty() ? dataset->getField() : dataset->getField(fieldname);
+  if (!field.valid())
+    return NetResponseError(HttpStatus::STATUS_BAD_REQUEST, "Cannot find fieldname(" + fieldname + ")");
+
+  auto logic_box = request.url.hasParam("box") ? BoxNi::parseFromOldFormatString(pdim, request.url.getParam("box")) : dataset->getLogicBox();
+  auto query = dataset->createBoxQuery(logic_box, field, time, 'r', Aborted());
+
+  //no end resolution means all of them, so the client can pick the highest one within its budget
+  query->end_resolutions = StringUtils::parseInts(request.url.getParam("endh"), ",");
+
+  auto access = dataset->createAccess();
+  auto costs = dataset->estimateBoxQueryCost(query, access);
+  if (costs.empty())
+    return NetResponseError(HttpStatus::STATUS_BAD_REQUEST, "dataset->estimateBoxQueryCost() failed");
+
+  StringTree stree("costs");
+  for (auto cost : costs)
+  {
+    StringTree child("cost");
+    cost.write(child);
+    stree.addChild(child);
+  }
+
+  NetResponse response(HttpStatus::STATUS_OK);
+  if (format == "xml")
+    response.setXmlBody(stree.toXmlString());
+  else if (format == "json")
+    response.setJSONBody(stree.toJSONString());
+  else
+    return NetResponseError(HttpStatus::STATUS_NOT_FOUND, "wrong format(" + format + ")");
+
+  return response;
+}
+
 ///////////////////////////////////////////////////////////////////////////
 NetResponse ModVisus::handlePointQuery(const NetRequest& request)
 {
@@ -775,6 +825,9 @@ NetResponse ModVisus::handleRequest(NetRequest request)
   else if (action == "pointquery")
     response = handlePointQuery(request);
 
+  else if (action == "boxquerycost")
+    response = handleBoxQueryCost(request);
+
   else if (action == "readdataset" || action == "read_dataset")
     response = handleReadDataset(request);
 
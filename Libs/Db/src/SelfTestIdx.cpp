@@ -38,6 +38,10 @@ For support : support@visus.net
 
 #include <Visus/Encoder.h>
 #include <Visus/IdxDataset.h>
+#include <Visus/IdxDiskAccess.h>
+#include <Visus/IdxBlockPresence.h>
+#include <Visus/DiskAccess.h>
+#include <Visus/IdxBoxQueryStream.h>
 #include <Visus/File.h>
 
 namespace Visus {
@@ -286,6 +290,1113 @@ protected:
 }; //end class 
 
 
+////////////////////////////////////////////////////////////////////////////////////
+static SharedPtr<IdxDataset> CreateSelfTestDataset(IdxFile idxfile)
+{
+  FileUtils::removeDirectory(Path("tmp/self_test_idx"));
+  String filename = "tmp/self_test_idx/temp.idx";
+  idxfile.save(filename);
+  auto ret = LoadIdxDataset(filename);
+  VisusReleaseAssert(ret);
+  return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+static Array GetSelfTestData(PointNi dims, DType dtype, int seed, int entropy = 256)
+{
+  Array ret(dims, dtype);
+  Uint32 x = (Uint32)seed * 2654435761u + 1;
+  for (Int64 I = 0; I < ret.c_size(); I++)
+  {
+    x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+    ret.c_ptr()[I] = (Uint8)(x % entropy);
+  }
+  return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+static void WriteSelfTestData(IdxDataset* dataset, SharedPtr<Access> access, Field field, double time, Array data)
+{
+  auto query = dataset->createBoxQuery(dataset->getLogicBox(), field, time, 'w');
+  dataset->beginBoxQuery(query);
+  VisusReleaseAssert(query->isRunning());
+  query->buffer = data;
+  VisusReleaseAssert(dataset->executeBoxQuery(access, query));
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+static Array ReadSelfTestData(IdxDataset* dataset, SharedPtr<Access> access, Field field, double time)
+{
+  auto query = dataset->createBoxQuery(dataset->getLogicBox(), field, time, 'r');
+  dataset->beginBoxQuery(query);
+  VisusReleaseAssert(query->isRunning());
+  VisusReleaseAssert(dataset->executeBoxQuery(access, query));
+  return query->buffer;
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+static bool SameSamples(Array a, Array b)
+{
+  return a.dtype == b.dtype && a.dims == b.dims && memcmp(a.c_ptr(), b.c_ptr(), (size_t)a.c_size()) == 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+static Int64 GetSelfTestDirectorySize(String dir)
+{
+  Int64 ret = 0;
+  for (auto name : FileUtils::listDirectory(Path(dir)))
+  {
+    String filename = dir + "/" + name;
+    ret += FileUtils::existsDirectory(Path(filename)) ? GetSelfTestDirectorySize(filename) : FileUtils::getFileSize(Path(filename));
+  }
+  return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+//rewritten blocks reuse the free extents of the file, compact removes the dead space
+static void SelfTestFreeExtents()
+{
+  IdxFile idxfile;
+  idxfile.logic_box = BoxNi(PointNi(0, 0), PointNi(256, 256));
+  Field field("myfield", DTypes::UINT8);
+  field.default_compression = "zip";
+  idxfile.fields.push_back(field);
+  idxfile.bitsperblock = 10;
+  idxfile.blocksperfile = 16;
+
+  auto dataset = CreateSelfTestDataset(idxfile);
+  field = dataset->getField();
+  auto dims = dataset->getLogicBox().size();
+  auto access = dataset->createAccess(StringTree("access").write("disable_async", true));
+
+  //blocks shrink and grow, without reuse the files would grow at each write
+  WriteSelfTestData(dataset.get(), access, field, 0, GetSelfTestData(dims, field.dtype, 0, 256));
+  Int64 first_size = GetSelfTestDirectorySize("tmp/self_test_idx");
+
+  Array data;
+  for (int I = 1; I <= 6; I++)
+  {
+    data = GetSelfTestData(dims, field.dtype, I, I % 2 ? 4 : 256);
+    WriteSelfTestData(dataset.get(), access, field, 0, data);
+    VisusReleaseAssert(SameSamples(ReadSelfTestData(dataset.get(), access, field, 0), data));
+  }
+
+  Int64 before_compact = GetSelfTestDirectorySize("tmp/self_test_idx");
+  VisusReleaseAssert(before_compact <= 2 * first_size);
+
+  auto disk_access = std::make_shared<IdxDiskAccess>(dataset.get(), StringTree("access").write("disable_async", true));
+  VisusReleaseAssert(disk_access->compact(2));
+  VisusReleaseAssert(GetSelfTestDirectorySize("tmp/self_test_idx") <= before_compact);
+  VisusReleaseAssert(SameSamples(ReadSelfTestData(dataset.get(), dataset->createAccess(), field, 0), data));
+
+  FileUtils::removeDirectory(Path("tmp/self_test_idx"));
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+//compressDataset with several threads (each one takes the next file) keeps all the samples of all the timesteps, and the sidecars usable
+static void SelfTestCompressDataset()
+{
+  IdxFile idxfile;
+  idxfile.logic_box = BoxNi(PointNi(0, 0), PointNi(256, 256));
+  idxfile.fields.push_back(Field("myfield", DTypes::UINT16));
+  idxfile.bitsperblock = 10;
+  idxfile.blocksperfile = 8;
+  idxfile.timesteps = DatasetTimesteps(0, 1, 1);
+  idxfile.time_template = "time_%02d/";
+
+  auto dataset = CreateSelfTestDataset(idxfile);
+  auto field = dataset->getField();
+  auto dims = dataset->getLogicBox().size();
+  auto access = dataset->createAccess(StringTree("access").write("disable_async", true));
+
+  std::vector<Array> data;
+  for (int T = 0; T <= 1; T++)
+  {
+    data.push_back(GetSelfTestData(dims, field.dtype, T, 16));
+    WriteSelfTestData(dataset.get(), access, field, T, data[T]);
+  }
+  access.reset();
+  VisusReleaseAssert(std::make_shared<IdxDiskAccess>(dataset.get())->scanBlockRanges());
+
+  Int64 uncompressed_size = GetSelfTestDirectorySize("tmp/self_test_idx");
+  dataset->compressDataset({ "zip" }, Array(), 4);
+  VisusReleaseAssert(GetSelfTestDirectorySize("tmp/self_test_idx") < uncompressed_size);
+
+  dataset = LoadIdxDataset("tmp/self_test_idx/temp.idx");
+  VisusReleaseAssert(dataset->getField().default_compression == "zip");
+  for (int T = 0; T <= 1; T++)
+  {
+    VisusReleaseAssert(SameSamples(ReadSelfTestData(dataset.get(), dataset->createAccess(), dataset->getField(), T), data[T]));
+    VisusReleaseAssert(dataset->createAccess()->getBlockRanges(dataset->getField(), T));
+  }
+
+  FileUtils::removeDirectory(Path("tmp/self_test_idx"));
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+//readahead only hints the blocks of the plan, reads must return the same samples with or without it
+static void SelfTestReadahead()
+{
+  IdxFile idxfile;
+  idxfile.logic_box = BoxNi(PointNi(0, 0, 0), PointNi(64, 64, 64));
+  for (auto name : { "field0", "field1" })
+  {
+    Field field(name, DTypes::UINT8);
+    field.default_compression = "zip";
+    idxfile.fields.push_back(field);
+  }
+  idxfile.bitsperblock = 10;
+  idxfile.blocksperfile = 16;
+
+  auto dataset = CreateSelfTestDataset(idxfile);
+  auto fields = dataset->getFields();
+  std::vector<Array> data;
+  for (int F = 0; F < (int)fields.size(); F++)
+  {
+    data.push_back(GetSelfTestData(dataset->getLogicBox().size(), fields[F].dtype, F, 32));
+    WriteSelfTestData(dataset.get(), dataset->createAccess(), fields[F], 0, data[F]);
+  }
+
+  for (auto readahead : { 1, 4, 1024 })
+  {
+    auto access = dataset->createAccess(StringTree("access").write("readahead", readahead));
+    for (int I = 0; I < 2; I++)
+      VisusReleaseAssert(SameSamples(ReadSelfTestData(dataset.get(), access, fields[0], 0), data[0]));
+
+    //all the fields in one pass, with one readahead plan
+    auto query = dataset->createBoxQuery(dataset->getLogicBox(), fields[0], 0, 'r');
+    dataset->beginBoxQuery(query);
+    VisusReleaseAssert(query->isRunning());
+    auto buffers = dataset->executeBoxQuery(access, query, fields, { 0.0 });
+    VisusReleaseAssert(buffers.size() == fields.size());
+    for (int F = 0; F < (int)fields.size(); F++)
+      VisusReleaseAssert(SameSamples(buffers[F], data[F]));
+  }
+
+  FileUtils::removeDirectory(Path("tmp/self_test_idx"));
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+//the presence sidecar skips the missing blocks, and never hides the blocks written after the scan
+static void SelfTestBlockPresence()
+{
+  IdxFile idxfile;
+  idxfile.logic_box = BoxNi(PointNi(0, 0), PointNi(512, 512));
+  idxfile.fields.push_back(Field("myfield", DTypes::UINT8));
+  idxfile.bitsperblock = 10;
+  idxfile.blocksperfile = 4;
+
+  auto dataset = CreateSelfTestDataset(idxfile);
+  auto field = dataset->getField();
+  auto dims = dataset->getLogicBox().size();
+
+  Array truth(dims, field.dtype);
+  truth.fillWithValue(0);
+
+  auto writeRegion = [&](BoxNi box, int seed, bool bUsePresence) {
+    auto access = dataset->createAccess(StringTree("access").write("disable_async", true).write("block_presence", bUsePresence));
+    auto query = dataset->createBoxQuery(box, field, 0, 'w');
+    dataset->beginBoxQuery(query);
+    VisusReleaseAssert(query->isRunning());
+    query->buffer = GetSelfTestData(query->getNumberOfSamples(), field.dtype, seed);
+    VisusReleaseAssert(dataset->executeBoxQuery(access, query));
+    VisusReleaseAssert(ArrayUtils::paste(truth, box, query->buffer, BoxNi(PointNi(2), query->buffer.dims)));
+  };
+
+  auto checkAll = [&]() {
+    BlockQuery::global_stats()->resetStats();
+    VisusReleaseAssert(SameSamples(ReadSelfTestData(dataset.get(), dataset->createAccess(), field, 0), truth));
+    return BlockQuery::global_stats()->getNumRead();
+  };
+
+  writeRegion(BoxNi(PointNi(0, 0), PointNi(64, 64)), 1, true);
+  auto nread_without = checkAll();
+
+  auto disk_access = std::make_shared<IdxDiskAccess>(dataset.get(), StringTree("access").write("disable_async", true));
+  VisusReleaseAssert(disk_access->scanBlockPresence());
+  VisusReleaseAssert(checkAll() < nread_without);
+
+  //blocks written after the scan
+  writeRegion(BoxNi(PointNi(256, 300), PointNi(400, 512)), 2, true);
+  checkAll();
+
+  //block_presence="false" is only for the reads, the writer still updates the bitmap
+  writeRegion(BoxNi(PointNi(0, 400), PointNi(100, 512)), 3, false);
+  checkAll();
+
+  //a writer that did not finish (e.g. crashed) makes the readers ignore the bitmap
+  IdxBlockPresence presence(IdxBlockPresence::getDefaultFilename("tmp/self_test_idx/temp.idx"));
+  presence.load();
+  VisusReleaseAssert(presence.getBitmap(field.name, 0));
+  presence.beginUpdate(field.name, 0);
+  checkAll();
+  presence.endUpdate(field.name, 0, {});
+  checkAll();
+
+  FileUtils::removeDirectory(Path("tmp/self_test_idx"));
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+//blocks with all samples equal are stored in the block header only, any read path must expand them
+static void SelfTestConstantBlocks()
+{
+  IdxFile idxfile;
+  idxfile.logic_box = BoxNi(PointNi(0, 0), PointNi(256, 256));
+  idxfile.fields.push_back(Field("myfield", DType::fromString("float32[3]")));
+  idxfile.bitsperblock = 10;
+  idxfile.blocksperfile = 16;
+
+  //half of the samples are zero, a quarter have the same value, the rest are random
+  auto dims = idxfile.logic_box.size();
+  auto data = GetSelfTestData(dims, idxfile.fields[0].dtype, 0);
+  auto sample_size = data.dtype.getByteSize();
+  for (auto it = ForEachPoint(dims); !it.end(); it.next())
+  {
+    auto ptr = data.c_ptr() + (it.pos[1] * dims[0] + it.pos[0]) * sample_size;
+    if (it.pos[1] < dims[1] / 2)
+      memset(ptr, 0, (size_t)sample_size);
+    else if (it.pos[0] < dims[0] / 2)
+      memset(ptr, 7, (size_t)sample_size);
+  }
+
+  Int64 stored_size[2] = { 0,0 };
+  for (auto bConstantBlocks : { false, true })
+  {
+    auto dataset = CreateSelfTestDataset(idxfile);
+    auto field = dataset->getField();
+    WriteSelfTestData(dataset.get(), dataset->createAccess(StringTree("access").write("constant_blocks", bConstantBlocks)), field, 0, data);
+    stored_size[bConstantBlocks ? 1 : 0] = GetSelfTestDirectorySize("tmp/self_test_idx");
+
+    for (auto config : { "<access disable_async='true' />", "<access />", "<access mmap='true' />" })
+      VisusReleaseAssert(SameSamples(ReadSelfTestData(dataset.get(), dataset->createAccess(StringTree::fromString(config)), field, 0), data));
+  }
+  VisusReleaseAssert(stored_size[1] < stored_size[0]);
+
+  FileUtils::removeDirectory(Path("tmp/self_test_idx"));
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+//the ranges sidecar prunes the blocks outside the value range, and follows the rewrites
+static void SelfTestBlockRanges()
+{
+  const double iso = 0.5;
+
+  auto getBump = [](PointNi dims, double cx, double cy) {
+    Array ret(dims, DTypes::FLOAT32);
+    auto ptr = (Float32*)ret.c_ptr();
+    for (auto it = ForEachPoint(dims); !it.end(); it.next())
+    {
+      double x = (double)it.pos[0] - cx, y = (double)it.pos[1] - cy;
+      *ptr++ = (Float32)std::exp(-(x * x + y * y) / 200.0);
+    }
+    return ret;
+  };
+
+  //samples on the same side of the isovalue, exact where needed
+  auto readIso = [&](IdxDataset* dataset, Array truth) {
+    auto access = dataset->createAccess(StringTree("access").write("disable_async", true));
+    auto query = dataset->createBoxQuery(dataset->getLogicBox(), dataset->getField(), 0, 'r');
+    query->setIsoValue(iso);
+    dataset->beginBoxQuery(query);
+    VisusReleaseAssert(dataset->executeBoxQuery(access, query));
+    auto got = (Float32*)query->buffer.c_ptr();
+    auto expected = (Float32*)truth.c_ptr();
+    for (Int64 I = 0; I < truth.getTotalNumberOfSamples(); I++)
+    {
+      VisusReleaseAssert((got[I] < iso) == (expected[I] < iso));
+      VisusReleaseAssert(expected[I] < iso || got[I] == expected[I]);
+    }
+    return query->value_range.npruned;
+  };
+
+  for (auto compression : { "zip", "zfp" })
+  {
+    IdxFile idxfile;
+    idxfile.logic_box = BoxNi(PointNi(0, 0), PointNi(512, 512));
+    Field field("myfield", DTypes::FLOAT32);
+    field.default_compression = compression;
+    idxfile.fields.push_back(field);
+    idxfile.bitsperblock = 10;
+    idxfile.blocksperfile = 32;
+
+    auto dataset = CreateSelfTestDataset(idxfile);
+    field = dataset->getField();
+    auto dims = dataset->getLogicBox().size();
+    bool bLossy = Encoders::getSingleton()->createEncoder(compression)->isLossy();
+
+    auto truth = getBump(dims, 100, 100);
+    WriteSelfTestData(dataset.get(), dataset->createAccess(), field, 0, truth);
+    if (!bLossy)
+      VisusReleaseAssert(readIso(dataset.get(), truth) == 0);
+
+    auto disk_access = std::make_shared<IdxDiskAccess>(dataset.get(), StringTree("access").write("disable_async", true));
+    VisusReleaseAssert(disk_access->scanBlockRanges());
+
+    //the scan stores the ranges of the decoded samples, so lossy blocks can be pruned too
+    auto decoded = ReadSelfTestData(dataset.get(), dataset->createAccess(), field, 0);
+    VisusReleaseAssert(readIso(dataset.get(), decoded) > 0);
+
+    //the write keeps the sidecar in sync, but a lossy write cannot know the decoded range
+    truth = getBump(dims, 400, 300);
+    WriteSelfTestData(dataset.get(), dataset->createAccess(), field, 0, truth);
+    decoded = ReadSelfTestData(dataset.get(), dataset->createAccess(), field, 0);
+    auto npruned = readIso(dataset.get(), decoded);
+    VisusReleaseAssert(bLossy ? npruned == 0 : npruned > 0);
+
+    //block_ranges="false" is only for the reads, the writer still updates the ranges
+    truth = getBump(dims, 100, 400);
+    WriteSelfTestData(dataset.get(), dataset->createAccess(StringTree("access").write("block_ranges", false)), field, 0, truth);
+    readIso(dataset.get(), ReadSelfTestData(dataset.get(), dataset->createAccess(), field, 0));
+  }
+
+  FileUtils::removeDirectory(Path("tmp/self_test_idx"));
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////
+//sharded disk cache: blocks packed in shard files read back the same as one file per block, holes stay missing
+static void SelfTestDiskAccessShards()
+{
+  IdxFile idxfile;
+  idxfile.logic_box = BoxNi(PointNi(0, 0), PointNi(256, 256));
+  idxfile.fields.push_back(Field("myfield", DTypes::UINT16));
+  idxfile.bitsperblock = 10;
+
+  auto dataset = CreateSelfTestDataset(idxfile);
+  auto field = dataset->getField();
+  WriteSelfTestData(dataset.get(), dataset->createAccess(), field, 0, GetSelfTestData(idxfile.logic_box.size(), field.dtype, 0, 16));
+
+  auto isHole = [](BigInt blockid) {
+    return blockid % 7 == 3;
+  };
+
+  auto source = dataset->createAccess();
+  auto nblocks = dataset->getTotalNumberOfBlocks();
+  std::vector<Array> blocks;
+  source->beginRead();
+  for (BigInt blockid = 0; blockid < nblocks; blockid++)
+  {
+    auto read = dataset->createBlockQuery(blockid, field, 0, 'r');
+    VisusReleaseAssert(dataset->executeBlockQueryAndWait(source, read));
+    if (!read->buffer.layout.empty())
+      VisusReleaseAssert(dataset->convertBlockQueryToRowMajor(read));
+    blocks.push_back(read->buffer);
+  }
+  source->endRead();
+
+  for (auto config : {
+    "<access type='diskaccess' dir='tmp/self_test_idx/cache0' compression='zip' />",
+    "<access type='diskaccess' dir='tmp/self_test_idx/cache4' shard_bits='4' compression='zip' />",
+    "<access type='diskaccess' dir='tmp/self_test_idx/cache4raw' shard_bits='4' compression='raw' />" })
+  {
+    auto cache = dataset->createAccess(StringTree::fromString(config));
+
+    //nothing written yet, reads must fail
+    cache->beginRead();
+    VisusReleaseAssert(!dataset->executeBlockQueryAndWait(cache, dataset->createBlockQuery(0, field, 0, 'r')));
+    cache->endRead();
+
+    cache->beginWrite();
+    for (BigInt blockid = 0; blockid < nblocks; blockid++)
+    {
+      if (isHole(blockid))
+        continue;
+
+      //write garbage first, then overwrite it with the right content
+      if (blockid % 5 == 0)
+      {
+        auto write = dataset->createBlockQuery(blockid, field, 0, 'w');
+        write->buffer = GetSelfTestData(blocks[(size_t)blockid].dims, field.dtype, (int)blockid + 1);
+        VisusReleaseAssert(dataset->executeBlockQueryAndWait(cache, write));
+      }
+
+      auto write = dataset->createBlockQuery(blockid, field, 0, 'w');
+      write->buffer = blocks[(size_t)blockid];
+      VisusReleaseAssert(dataset->executeBlockQueryAndWait(cache, write));
+    }
+    cache->endWrite();
+
+    cache->beginRead();
+    for (BigInt blockid = 0; blockid < nblocks; blockid++)
+    {
+      auto read = dataset->createBlockQuery(blockid, field, 0, 'r');
+      bool bOk = dataset->executeBlockQueryAndWait(cache, read);
+      VisusReleaseAssert(bOk == !isHole(blockid));
+      if (bOk)
+      {
+        if (!read->buffer.layout.empty())
+          VisusReleaseAssert(dataset->convertBlockQueryToRowMajor(read));
+        VisusReleaseAssert(SameSamples(read->buffer, blocks[(size_t)blockid]));
+      }
+    }
+    cache->endRead();
+  }
+
+  FileUtils::removeDirectory(Path("tmp/self_test_idx"));
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////
+//bounded disk cache: the files stay inside the budget, the surviving blocks keep their content
+static void SelfTestDiskAccessEviction()
+{
+  IdxFile idxfile;
+  idxfile.logic_box = BoxNi(PointNi(0, 0), PointNi(256, 256));
+  idxfile.fields.push_back(Field("myfield", DTypes::UINT16));
+  idxfile.bitsperblock = 10;
+
+  auto dataset = CreateSelfTestDataset(idxfile);
+  auto field = dataset->getField();
+  auto nblocks = dataset->getTotalNumberOfBlocks();
+  String dir = "tmp/self_test_idx/cache";
+
+  auto getBlockData = [&](BigInt blockid) {
+    auto query = dataset->createBlockQuery(blockid, field, 0, 'r');
+    return GetSelfTestData(query->getNumberOfSamples(), field.dtype, (int)blockid);
+  };
+
+  //size of the cached files, without the usage bookkeeping
+  auto getCacheSize = [&]() {
+    Int64 ret = GetSelfTestDirectorySize(dir);
+    for (auto name : { "cache.usage", "cache.usage.journal" })
+    {
+      if (FileUtils::existsFile(Path(dir + "/" + name)))
+        ret -= FileUtils::getFileSize(Path(dir + "/" + name));
+    }
+    return ret;
+  };
+
+  auto writeBlocks = [&](SharedPtr<Access> cache, BigInt from, BigInt to) {
+    cache->beginWrite();
+    for (BigInt blockid = from; blockid < to; blockid++)
+    {
+      auto write = dataset->createBlockQuery(blockid, field, 0, 'w');
+      write->buffer = getBlockData(blockid);
+      VisusReleaseAssert(dataset->executeBlockQueryAndWait(cache, write));
+    }
+    cache->endWrite();
+  };
+
+  const Int64 available = 32 * 1024;
+  for (auto eviction : { "lru", "lfu" })
+  {
+    FileUtils::removeDirectory(Path(dir));
+    auto cache = dataset->createAccess(StringTree::fromString(
+      "<access type='diskaccess' dir='" + dir + "' compression='raw' available='32kb' eviction='" + String(eviction) + "' />"));
+
+    //the whole dataset is 4 times the budget
+    writeBlocks(cache, 0, nblocks);
+    VisusReleaseAssert(getCacheSize() > 0 && getCacheSize() <= available);
+
+    int ncached = 0;
+    cache->beginRead();
+    for (BigInt blockid = 0; blockid < nblocks; blockid++)
+    {
+      auto read = dataset->createBlockQuery(blockid, field, 0, 'r');
+      if (!dataset->executeBlockQueryAndWait(cache, read))
+        continue;
+      VisusReleaseAssert(SameSamples(read->buffer, getBlockData(blockid)));
+      ncached++;
+    }
+    cache->endRead();
+    VisusReleaseAssert(ncached > 0 && ncached < nblocks);
+  }
+
+  //a new cache without bookkeeping finds the existing files and evicts them for a smaller budget
+  FileUtils::removeFile(Path(dir + "/cache.usage"));
+  FileUtils::removeFile(Path(dir + "/cache.usage.journal"));
+  VisusReleaseAssert(getCacheSize() > 0);
+  writeBlocks(dataset->createAccess(StringTree::fromString("<access type='diskaccess' dir='" + dir + "' compression='raw' available='1kb' />")), 0, 1);
+  VisusReleaseAssert(getCacheSize() == 0);
+
+  FileUtils::removeDirectory(Path("tmp/self_test_idx"));
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////
+//the scatter kernel (with and without recorded spans) merges hzorder blocks exactly like the scalar one
+static void SelfTestHzScatter()
+{
+  for (auto logic_box : { BoxNi(PointNi(0, 0), PointNi(256, 128)), BoxNi(PointNi(0, 0, 0), PointNi(32, 64, 16)) })
+  {
+    IdxFile idxfile;
+    idxfile.logic_box = logic_box;
+    idxfile.fields.push_back(Field("myfield", DType::fromString("uint16[3]")));
+    idxfile.bitsperblock = 10;
+
+    auto dataset = CreateSelfTestDataset(idxfile);
+    auto field = dataset->getField();
+    int pdim = dataset->getPointDim();
+    int bitsperblock = dataset->getDefaultBitsPerBlock();
+    BoxNi box(logic_box.p1 + PointNi::one(pdim) * 3, logic_box.p2 - PointNi::one(pdim) * 5);
+
+    for (int end_resolution : { dataset->getMaxResolution(), dataset->getMaxResolution() - 3 })
+    {
+      auto createQuery = [&]() {
+        auto query = dataset->createBoxQuery(box, field, 0, 'r');
+        query->end_resolutions = { end_resolution };
+        dataset->beginBoxQuery(query);
+        VisusReleaseAssert(query->isRunning() && query->allocateBufferIfNeeded());
+        return query;
+      };
+
+      //synthetic blocks, each sample is different
+      auto plan = dataset->createBoxQueryPlan(createQuery().get(), bitsperblock);
+      VisusReleaseAssert(plan && !plan->blocks.empty());
+      std::vector< SharedPtr<BlockQuery> > blocks;
+      for (auto blockid : plan->blocks)
+      {
+        auto block = dataset->createBlockQuery(blockid, field, 0, 'r');
+        VisusReleaseAssert(block->allocateBufferIfNeeded());
+        block->buffer.layout = "hzorder";
+        auto ptr = block->buffer.c_ptr();
+        for (Int64 I = 0, N = block->buffer.c_size(); I < N; I++)
+          ptr[I] = (Uint8)(blockid * 31 + I * 7);
+        blocks.push_back(block);
+      }
+
+      auto merge = [&](SharedPtr<IdxBoxQueryPlan> plan) {
+        auto query = createQuery();
+        query->plan = plan;
+        for (auto block : blocks)
+          VisusReleaseAssert(dataset->mergeBoxQueryWithBlockQuery(query, block));
+        return query->buffer;
+      };
+
+      auto expected = merge(SharedPtr<IdxBoxQueryPlan>());
+
+      //no memory for spans, the scatter offsets are used every time
+      auto scatter = dataset->createBoxQueryPlan(createQuery().get(), bitsperblock, 0);
+      VisusReleaseAssert(SameSamples(merge(scatter), expected));
+      VisusReleaseAssert(SameSamples(merge(scatter), expected));
+      for (auto blockid : plan->blocks)
+        VisusReleaseAssert(!scatter->getSpans(blockid));
+
+      //the first merge records the spans, the second one replays them
+      auto spans = dataset->createBoxQueryPlan(createQuery().get(), bitsperblock, std::numeric_limits<Int64>::max());
+      VisusReleaseAssert(SameSamples(merge(spans), expected));
+      VisusReleaseAssert(spans->getSpans(plan->blocks[0]));
+      VisusReleaseAssert(SameSamples(merge(spans), expected));
+    }
+  }
+
+  FileUtils::removeDirectory(Path("tmp/self_test_idx"));
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////
+//streamed tiles have the same samples as one query of the whole region, with tiles inside the memory budget
+static void SelfTestBoxQueryStream()
+{
+  IdxFile idxfile;
+  idxfile.logic_box = BoxNi(PointNi(0, 0), PointNi(256, 256));
+  idxfile.fields.push_back(Field("myfield", DTypes::UINT16));
+  Field filtered("filtered", DTypes::UINT16);
+  filtered.filter = "identity";
+  idxfile.fields.push_back(filtered);
+  idxfile.bitsperblock = 10;
+
+  auto dataset = CreateSelfTestDataset(idxfile);
+  auto field = dataset->getField();
+  WriteSelfTestData(dataset.get(), dataset->createAccess(), field, 0, GetSelfTestData(idxfile.logic_box.size(), field.dtype, 0));
+
+  auto access = dataset->createAccess();
+  auto sample_size = field.dtype.getByteSize(1);
+  BoxNi box(PointNi(3, 5), PointNi(250, 241));
+
+  for (int end_resolution : { dataset->getMaxResolution(), dataset->getMaxResolution() - 2 })
+  {
+    auto createQuery = [&]() {
+      auto query = dataset->createBoxQuery(box, field, 0, 'r');
+      query->end_resolutions = { end_resolution };
+      query->disableFilters();
+      dataset->beginBoxQuery(query);
+      VisusReleaseAssert(query->isRunning());
+      return query;
+    };
+
+    auto full = createQuery();
+    VisusReleaseAssert(dataset->executeBoxQuery(access, full));
+
+    for (Int64 max_memory : { (Int64)0, (Int64)16 * 1024 })
+    {
+      auto query = createQuery();
+      auto logic_samples = query->logic_samples;
+      Int64 nsamples = 0;
+      bool bOk = dataset->streamBoxQuery(access, query, PointNi(), [&](BoxNi logic_box, Array tile) {
+        VisusReleaseAssert(max_memory == 0 || tile.c_size() <= max_memory / 2);
+        auto offset = logic_samples.logicToPixel(logic_box.p1);
+        for (auto it = ForEachPoint(tile.dims); !it.end(); it.next())
+        {
+          auto pixel = offset + it.pos;
+          auto src = tile.c_ptr() + (it.pos[1] * tile.dims[0] + it.pos[0]) * sample_size;
+          auto dst = full->buffer.c_ptr() + (pixel[1] * full->buffer.dims[0] + pixel[0]) * sample_size;
+          VisusReleaseAssert(memcmp(src, dst, (size_t)sample_size) == 0);
+        }
+        nsamples += tile.dims.innerProduct();
+        return true;
+      }, max_memory);
+      VisusReleaseAssert(bOk);
+      VisusReleaseAssert(nsamples == full->buffer.dims.innerProduct());
+    }
+  }
+
+  //filters need the samples outside the tile
+  {
+    auto query = dataset->createBoxQuery(box, dataset->getField("filtered"), 0, 'r');
+    query->enableFilters();
+    dataset->beginBoxQuery(query);
+    VisusReleaseAssert(!dataset->streamBoxQuery(access, query, PointNi(), [](BoxNi, Array) {return true; }));
+  }
+
+  FileUtils::removeDirectory(Path("tmp/self_test_idx"));
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////
+//executeBoxQueries gives the same samples as running the queries one by one, sharing the block reads
+static void SelfTestBoxQueries()
+{
+  IdxFile idxfile;
+  idxfile.logic_box = BoxNi(PointNi(0, 0), PointNi(256, 256));
+  idxfile.fields.push_back(Field("field0", DTypes::UINT8));
+  idxfile.fields.push_back(Field("field1", DType::fromString("float32[2]")));
+  idxfile.bitsperblock = 10;
+
+  auto dataset = CreateSelfTestDataset(idxfile);
+  auto logic_box = dataset->getLogicBox();
+  for (int F = 0; F < (int)idxfile.fields.size(); F++)
+  {
+    auto field = dataset->getField(idxfile.fields[F].name);
+    WriteSelfTestData(dataset.get(), dataset->createAccess(), field, 0, GetSelfTestData(logic_box.size(), field.dtype, F));
+  }
+
+  //full resolution, slices, thumbnails and subregions of both fields
+  const int N = 12;
+  auto createQueries = [&]() {
+    std::vector< SharedPtr<BoxQuery> > ret;
+    for (int I = 0; I < N; I++)
+    {
+      BoxNi box = logic_box;
+      int end_resolution = dataset->getMaxResolution();
+      if (I % 4 == 1) { box.p1[1] = 100 + I; box.p2[1] = box.p1[1] + 1; }
+      if (I % 4 == 2) end_resolution -= 4;
+      if (I % 4 == 3) box = BoxNi(PointNi(64 - I, 32), PointNi(170, 200 + I));
+      auto query = dataset->createBoxQuery(box, dataset->getField(idxfile.fields[(I / 4) % 2].name), 0, 'r');
+      query->end_resolutions = { end_resolution };
+      dataset->beginBoxQuery(query);
+      VisusReleaseAssert(query->isRunning());
+      ret.push_back(query);
+    }
+    return ret;
+  };
+
+  auto access = dataset->createAccess();
+  BlockQuery::global_stats()->resetStats();
+  auto single = createQueries();
+  for (auto query : single)
+    VisusReleaseAssert(dataset->executeBoxQuery(access, query));
+  auto single_reads = BlockQuery::global_stats()->getNumRead();
+
+  for (auto config : { "<access />", "<access merge_nthreads='4' />", "<access disable_async='true' />" })
+  {
+    BlockQuery::global_stats()->resetStats();
+    auto batch = createQueries();
+    VisusReleaseAssert(dataset->executeBoxQueries(dataset->createAccess(StringTree::fromString(config)), batch));
+    VisusReleaseAssert(BlockQuery::global_stats()->getNumRead() < single_reads);
+    for (int I = 0; I < N; I++)
+    {
+      VisusReleaseAssert(batch[I]->isRunning() && batch[I]->getCurrentResolution() == batch[I]->getEndResolution());
+      VisusReleaseAssert(SameSamples(batch[I]->buffer, single[I]->buffer));
+    }
+  }
+
+  //an aborted query does not abort the others
+  {
+    auto batch = createQueries();
+    batch[5]->aborted.setTrue();
+    VisusReleaseAssert(!dataset->executeBoxQueries(access, batch));
+    for (int I = 0; I < N; I++)
+    {
+      bool bOk = I == 5 ? batch[I]->failed() && batch[I]->errormsg == "query aborted" : SameSamples(batch[I]->buffer, single[I]->buffer);
+      VisusReleaseAssert(bOk);
+    }
+  }
+
+  //all queries aborted, nothing is read
+  {
+    auto batch = createQueries();
+    for (auto query : batch)
+      query->aborted.setTrue();
+    BlockQuery::global_stats()->resetStats();
+    VisusReleaseAssert(!dataset->executeBoxQueries(access, batch));
+    VisusReleaseAssert(BlockQuery::global_stats()->getNumRead() == 0);
+    for (auto query : batch)
+      VisusReleaseAssert(query->failed() && query->errormsg == "query aborted");
+  }
+
+  FileUtils::removeDirectory(Path("tmp/self_test_idx"));
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////
+//a thread blocked on a semaphore or on a future wakes up when another thread aborts it
+static void SelfTestAborted()
+{
+  auto abortLater = [](Aborted aborted) {
+    return Thread::start("SelfTestAborted", [aborted]() {
+      Thread::sleep(50);
+      Aborted(aborted).setTrue();
+    });
+  };
+
+  //callbacks run once
+  {
+    Aborted aborted;
+    int ncalls = 0;
+    auto id = aborted.addCallback([&]() {ncalls++; });
+    aborted.setTrue();
+    aborted.setTrue();
+    aborted.removeCallback(id);
+    VisusReleaseAssert(ncalls == 1);
+  }
+
+  //semaphore: an aborted down does not take the resource
+  {
+    Semaphore semaphore;
+    Aborted aborted;
+    auto thread = abortLater(aborted);
+    VisusReleaseAssert(!semaphore.down(aborted));
+    Thread::join(thread);
+    VisusReleaseAssert(!semaphore.tryDown());
+    semaphore.up();
+    VisusReleaseAssert(semaphore.down(Aborted()));
+  }
+
+  //future: a value never set
+  {
+    Promise<int> promise;
+    Aborted aborted;
+    auto thread = abortLater(aborted);
+    VisusReleaseAssert(!promise.get_future().wait(aborted));
+    Thread::join(thread);
+
+    Promise<int> ready;
+    ready.set_value(1);
+    VisusReleaseAssert(ready.get_future().wait(Aborted()));
+  }
+
+  //a partial write aborted while reading the blocks to merge never writes a block it could not read
+  {
+    IdxFile idxfile;
+    idxfile.logic_box = BoxNi(PointNi(0, 0), PointNi(512, 512));
+    idxfile.fields.push_back(Field("myfield", DTypes::UINT8));
+    idxfile.bitsperblock = 8;
+
+    auto dataset = CreateSelfTestDataset(idxfile);
+    auto field = dataset->getField();
+    auto dims = dataset->getLogicBox().size();
+    auto before = GetSelfTestData(dims, field.dtype, 1);
+    auto after = GetSelfTestData(dims, field.dtype, 2);
+
+    for (auto config : { "<access />", "<access write_nthreads='2' />" })
+    {
+      for (int delay : { 0, 1, 2, 5, 20 })
+      {
+        auto access = dataset->createAccess(StringTree::fromString(config));
+        WriteSelfTestData(dataset.get(), access, field, 0, before);
+
+        BoxNi box(PointNi(1, 1), PointNi(511, 511));
+        auto query = dataset->createBoxQuery(box, field, 0, 'w');
+        dataset->beginBoxQuery(query);
+        VisusReleaseAssert(query->isRunning());
+        auto buffer = Array(query->getNumberOfSamples(), field.dtype);
+        VisusReleaseAssert(ArrayUtils::paste(buffer, BoxNi(PointNi(2), buffer.dims), after, box));
+        query->buffer = buffer;
+
+        auto thread = Thread::start("SelfTestAborted", [delay, query]() {
+          Thread::sleep(delay);
+          query->aborted.setTrue();
+        });
+        dataset->executeBoxQuery(access, query);
+        Thread::join(thread);
+
+        //each sample is the old or the new one, outside the box always the old one
+        auto got = ReadSelfTestData(dataset.get(), access, field, 0);
+        for (auto it = ForEachPoint(dims); !it.end(); it.next())
+        {
+          auto I = it.pos[1] * dims[0] + it.pos[0];
+          auto value = got.c_ptr()[I];
+          VisusReleaseAssert(value == before.c_ptr()[I] || (box.containsPoint(it.pos) && value == after.c_ptr()[I]));
+        }
+      }
+    }
+
+    FileUtils::removeDirectory(Path("tmp/self_test_idx"));
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////
+//point queries at integer points have the samples of a box read of the same region, converted on one thread or on the pool
+static void SelfTestPointQuery()
+{
+  IdxFile idxfile;
+  idxfile.logic_box = BoxNi(PointNi(0, 0, 0), PointNi(64, 64, 64));
+  idxfile.fields.push_back(Field("myfield", DTypes::UINT16));
+  idxfile.bitsperblock = 12;
+
+  auto dataset = CreateSelfTestDataset(idxfile);
+  auto field = dataset->getField();
+  WriteSelfTestData(dataset.get(), dataset->createAccess(), field, 0, GetSelfTestData(idxfile.logic_box.size(), field.dtype, 0));
+
+  auto access = dataset->createAccess();
+  auto sample_size = field.dtype.getByteSize(1);
+  auto tpool = IdxPointQueryThreadPool::getSingleton();
+
+  //16^3 points fit in one chunk, 64^3 points are converted in several chunks
+  for (int N : { 16, 64 })
+  {
+    for (bool bPool : { false, true })
+    {
+      IdxPointQueryThreadPool::setSingleton(bPool ? tpool : nullptr);
+
+      auto query = dataset->createPointQuery(Position(BoxNd(PointNd(1.5, 2.5, 3.5), PointNd(62.0, 61.0, 63.0))), field, 0);
+      query->end_resolutions = { dataset->getMaxResolution() };
+      dataset->beginPointQuery(query);
+      VisusReleaseAssert(query->isRunning());
+      VisusReleaseAssert(query->setPoints(PointNi(N, N, N)));
+      VisusReleaseAssert(dataset->executePointQuery(access, query));
+
+      auto points = (const Int64*)query->points->c_ptr();
+      auto npoints = query->getNumberOfPoints().innerProduct();
+      BoxNi box = BoxNi::invalid();
+      for (Int64 I = 0; I < npoints; I++)
+        box = box.getUnion(BoxNi(PointNi(points[3 * I + 0], points[3 * I + 1], points[3 * I + 2]), PointNi(points[3 * I + 0] + 1, points[3 * I + 1] + 1, points[3 * I + 2] + 1)));
+
+      auto read = dataset->createBoxQuery(box, field, 0, 'r');
+      dataset->beginBoxQuery(read);
+      VisusReleaseAssert(read->isRunning());
+      VisusReleaseAssert(dataset->executeBoxQuery(access, read));
+      VisusReleaseAssert(read->buffer.dims == box.size());
+
+      auto dims = read->buffer.dims;
+      for (Int64 I = 0; I < npoints; I++)
+      {
+        auto p = PointNi(points[3 * I + 0], points[3 * I + 1], points[3 * I + 2]) - box.p1;
+        auto offset = ((p[2] * dims[1] + p[1]) * dims[0] + p[0]) * sample_size;
+        VisusReleaseAssert(memcmp(query->buffer.c_ptr() + I * sample_size, read->buffer.c_ptr() + offset, (size_t)sample_size) == 0);
+      }
+    }
+  }
+  IdxPointQueryThreadPool::setSingleton(tpool);
+
+  FileUtils::removeDirectory(Path("tmp/self_test_idx"));
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////
+//reads back known data (hzorder and rowmajor, raw and zip) with the access config: the whole box, a region with gaps between its blocks, one block at a time
+static void SelfTestReadBack(String config)
+{
+  for (auto layout : { "hzorder", "rowmajor" })
+  {
+    for (auto compression : { "raw", "zip" })
+    {
+      IdxFile idxfile;
+      idxfile.logic_box = BoxNi(PointNi(0, 0, 0), PointNi(64, 64, 64));
+      Field field("myfield", DTypes::UINT16, layout);
+      field.default_compression = compression;
+      idxfile.fields.push_back(field);
+      idxfile.bitsperblock = 10;
+      idxfile.blocksperfile = 64;
+
+      auto dataset = CreateSelfTestDataset(idxfile);
+      field = dataset->getField();
+      auto data = GetSelfTestData(idxfile.logic_box.size(), field.dtype, 0, 64);
+      WriteSelfTestData(dataset.get(), dataset->createAccess(), field, 0, data);
+
+      auto access = dataset->createAccess(StringTree::fromString(config));
+      for (int I = 0; I < 2; I++)
+        VisusReleaseAssert(SameSamples(ReadSelfTestData(dataset.get(), access, field, 0), data));
+
+      BoxNi box(PointNi(5, 9, 13), PointNi(40, 50, 60));
+      auto query = dataset->createBoxQuery(box, field, 0, 'r');
+      dataset->beginBoxQuery(query);
+      VisusReleaseAssert(query->isRunning());
+      VisusReleaseAssert(dataset->executeBoxQuery(access, query));
+      Array expected(box.size(), field.dtype);
+      VisusReleaseAssert(ArrayUtils::paste(expected, BoxNi(PointNi(3), expected.dims), data, box));
+      VisusReleaseAssert(SameSamples(query->buffer, expected));
+
+      auto reference = dataset->createAccess(StringTree("access").write("disable_async", true));
+      access->beginRead();
+      reference->beginRead();
+      for (BigInt blockid = 0; blockid < dataset->getTotalNumberOfBlocks(); blockid++)
+      {
+        auto read = dataset->createBlockQuery(blockid, field, 0, 'r');
+        auto expected = dataset->createBlockQuery(blockid, field, 0, 'r');
+        VisusReleaseAssert(dataset->executeBlockQueryAndWait(access, read));
+        VisusReleaseAssert(dataset->executeBlockQueryAndWait(reference, expected));
+        VisusReleaseAssert(read->buffer.layout == expected->buffer.layout && SameSamples(read->buffer, expected->buffer));
+      }
+      access->endRead();
+      reference->endRead();
+    }
+  }
+
+  FileUtils::removeDirectory(Path("tmp/self_test_idx"));
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+//io_uring reads (all the reads of a file in flight at the same time), and reads aborted while in flight
+static void SelfTestIoUring()
+{
+  if (!File::isIoUringAvailable())
+  {
+    PrintInfo("io_uring not available, skipped");
+    return;
+  }
+
+  SelfTestReadBack("<access io_uring='true' />");
+  SelfTestReadBack("<access io_uring='true' disable_async='true' />");
+
+  IdxFile idxfile;
+  idxfile.logic_box = BoxNi(PointNi(0, 0, 0), PointNi(128, 128, 128));
+  idxfile.fields.push_back(Field("myfield", DTypes::UINT8));
+  idxfile.bitsperblock = 10;
+
+  auto dataset = CreateSelfTestDataset(idxfile);
+  auto field = dataset->getField();
+  auto data = GetSelfTestData(idxfile.logic_box.size(), field.dtype, 0);
+  WriteSelfTestData(dataset.get(), dataset->createAccess(), field, 0, data);
+
+  auto access = dataset->createAccess(StringTree::fromString("<access io_uring='true' />"));
+  for (int delay : { 0, 1, 2, 5 })
+  {
+    auto query = dataset->createBoxQuery(dataset->getLogicBox(), field, 0, 'r');
+    dataset->beginBoxQuery(query);
+    VisusReleaseAssert(query->isRunning());
+    auto thread = Thread::start("SelfTestIoUring", [delay, query]() {
+      Thread::sleep(delay);
+      query->aborted.setTrue();
+    });
+    bool bOk = dataset->executeBoxQuery(access, query);
+    Thread::join(thread);
+    VisusReleaseAssert(!bOk || SameSamples(query->buffer, data));
+
+    //the access is still usable
+    VisusReleaseAssert(SameSamples(ReadSelfTestData(dataset.get(), access, field, 0), data));
+  }
+
+  FileUtils::removeDirectory(Path("tmp/self_test_idx"));
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////
+//memory mapped reads: raw blocks are views of the mapping, and stay valid after the access and its files are closed
+static void SelfTestMemoryMapping()
+{
+  SelfTestReadBack("<access mmap='true' />");
+  SelfTestReadBack("<access mmap='true' disable_async='true' />");
+
+  IdxFile idxfile;
+  idxfile.logic_box = BoxNi(PointNi(0, 0), PointNi(256, 256));
+  Field field("myfield", DTypes::UINT8);
+  field.default_compression = "raw";
+  idxfile.fields.push_back(field);
+  idxfile.bitsperblock = 10;
+  idxfile.blocksperfile = 4;
+
+  auto dataset = CreateSelfTestDataset(idxfile);
+  field = dataset->getField();
+  WriteSelfTestData(dataset.get(), dataset->createAccess(), field, 0, GetSelfTestData(idxfile.logic_box.size(), field.dtype, 0));
+
+  std::vector< SharedPtr<BlockQuery> > expected;
+  auto reference = dataset->createAccess(StringTree("access").write("disable_async", true));
+  reference->beginRead();
+  for (BigInt blockid = 0; blockid < dataset->getTotalNumberOfBlocks(); blockid++)
+  {
+    auto read = dataset->createBlockQuery(blockid, field, 0, 'r');
+    VisusReleaseAssert(dataset->executeBlockQueryAndWait(reference, read));
+    expected.push_back(read);
+  }
+  reference->endRead();
+
+  //blocks of several files, some of them released before the access
+  std::vector< SharedPtr<BlockQuery> > blocks;
+  {
+    auto access = dataset->createAccess(StringTree::fromString("<access mmap='true' />"));
+    access->beginRead();
+    for (BigInt blockid = 0; blockid < dataset->getTotalNumberOfBlocks(); blockid++)
+    {
+      auto read = dataset->createBlockQuery(blockid, field, 0, 'r');
+      VisusReleaseAssert(dataset->executeBlockQueryAndWait(access, read));
+      if (blockid % 3)
+        blocks.push_back(read);
+    }
+    access->endRead();
+  }
+
+  for (auto read : blocks)
+    VisusReleaseAssert(SameSamples(read->buffer, expected[(size_t)read->blockid]->buffer));
+
+  FileUtils::removeDirectory(Path("tmp/self_test_idx"));
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////
+//partial writes (read-modify-write of the blocks) with the encode/write pipeline give the same dataset as the serial writes
+static void SelfTestWritePipeline()
+{
+  std::vector<BoxNi> boxes = {
+    BoxNi(PointNi(0, 0), PointNi(256, 256)),
+    BoxNi(PointNi(3, 7), PointNi(200, 101)),
+    BoxNi(PointNi(50, 60), PointNi(251, 255)),
+    BoxNi(PointNi(100, 1), PointNi(101, 256)),
+    BoxNi(PointNi(17, 33), PointNi(18, 34))
+  };
+
+  for (auto layout : { "hzorder", "rowmajor" })
+  {
+    Array result[2];
+    for (auto config : { "<access disable_async='true' />", "<access write_nthreads='4' />" })
+    {
+      IdxFile idxfile;
+      idxfile.logic_box = BoxNi(PointNi(0, 0), PointNi(256, 256));
+      Field field("myfield", DType::fromString("uint8[3]"), layout);
+      field.default_compression = "zip";
+      idxfile.fields.push_back(field);
+      idxfile.bitsperblock = 8;
+      idxfile.blocksperfile = 16;
+
+      auto dataset = CreateSelfTestDataset(idxfile);
+      field = dataset->getField();
+      Array truth(idxfile.logic_box.size(), field.dtype);
+      truth.fillWithValue(0);
+
+      auto access = dataset->createAccess(StringTree::fromString(config));
+      for (int I = 0; I < (int)boxes.size(); I++)
+      {
+        auto query = dataset->createBoxQuery(boxes[I], field, 0, 'w');
+        dataset->beginBoxQuery(query);
+        VisusReleaseAssert(query->isRunning());
+        query->buffer = GetSelfTestData(query->getNumberOfSamples(), field.dtype, I);
+        VisusReleaseAssert(dataset->executeBoxQuery(access, query));
+        VisusReleaseAssert(ArrayUtils::paste(truth, boxes[I], query->buffer, BoxNi(PointNi(2), query->buffer.dims)));
+      }
+
+      auto& got = result[StringUtils::contains(config, "write_nthreads") ? 1 : 0];
+      got = ReadSelfTestData(dataset.get(), dataset->createAccess(), field, 0);
+      VisusReleaseAssert(SameSamples(got, truth));
+    }
+    VisusReleaseAssert(SameSamples(result[0], result[1]));
+  }
+
+  FileUtils::removeDirectory(Path("tmp/self_test_idx"));
+}
+
+
 /////////////////////////////////////////////////////
 void SelfTestIdx(int max_seconds)
 {
@@ -355,6 +1466,71 @@ void SelfTestIdx(int max_seconds)
     }
   }
 
+  //round trips of the storage, access and query features
+  PrintInfo("Running SelfTestFreeExtents...");
+  SelfTestFreeExtents();
+  PrintInfo("...done");
+
+  PrintInfo("Running SelfTestCompressDataset...");
+  SelfTestCompressDataset();
+  PrintInfo("...done");
+
+  PrintInfo("Running SelfTestReadahead...");
+  SelfTestReadahead();
+  PrintInfo("...done");
+
+  PrintInfo("Running SelfTestBlockPresence...");
+  SelfTestBlockPresence();
+  PrintInfo("...done");
+
+  PrintInfo("Running SelfTestConstantBlocks...");
+  SelfTestConstantBlocks();
+  PrintInfo("...done");
+
+  PrintInfo("Running SelfTestBlockRanges...");
+  SelfTestBlockRanges();
+  PrintInfo("...done");
+
+  PrintInfo("Running SelfTestDiskAccessShards...");
+  SelfTestDiskAccessShards();
+  PrintInfo("...done");
+
+  PrintInfo("Running SelfTestDiskAccessEviction...");
+  SelfTestDiskAccessEviction();
+  PrintInfo("...done");
+
+  PrintInfo("Running SelfTestHzScatter...");
+  SelfTestHzScatter();
+  PrintInfo("...done");
+
+  PrintInfo("Running SelfTestBoxQueryStream...");
+  SelfTestBoxQueryStream();
+  PrintInfo("...done");
+
+  PrintInfo("Running SelfTestBoxQueries...");
+  SelfTestBoxQueries();
+  PrintInfo("...done");
+
+  PrintInfo("Running SelfTestAborted...");
+  SelfTestAborted();
+  PrintInfo("...done");
+
+  PrintInfo("Running SelfTestPointQuery...");
+  SelfTestPointQuery();
+  PrintInfo("...done");
+
+  PrintInfo("Running SelfTestIoUring...");
+  SelfTestIoUring();
+  PrintInfo("...done");
+
+  PrintInfo("Running SelfTestMemoryMapping...");
+  SelfTestMemoryMapping();
+  PrintInfo("...done");
+
+  PrintInfo("Running SelfTestWritePipeline...");
+  SelfTestWritePipeline();
+  PrintInfo("...done");
+
   while (true)
   {
     if (max_seconds > 0 && t1.elapsedSec() > max_seconds)
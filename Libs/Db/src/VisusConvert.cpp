@@ -54,6 +54,8 @@ For support : support@visus.net
 #include <Visus/IdxMultipleDataset.h>
 #include <Visus/MultiplexAccess.h>
 
+#include <limits>
+
 namespace Visus {
 
   ///////////////////////////////////////////////////////////
@@ -582,6 +584,237 @@ public:
   }
 };
 
+///////////////////////////////////////////////////////////
+class CompactIdx : public VisusConvert::Step
+{
+public:
+
+  //getHelp
+  virtual String getHelp(std::vector<String> args) override
+  {
+    std::ostringstream out;
+    out << args[0]
+      << " <filename.idx>" << std::endl
+      << "   [--nthreads <int>]" << std::endl;
+    return out.str();
+  }
+
+  //exec
+  virtual Array exec(Array data, std::vector<String> args) override
+  {
+    if (args.size() < 2)
+      ThrowException(args[0], "syntax error");
+
+    String filename = args[1];
+
+    int nthreads = 0;
+    for (int I = 2; I < (int)args.size(); I++)
+    {
+      if (args[I] == "--nthreads")
+        nthreads = cint(args[++I]);
+    }
+
+    auto db = LoadIdxDataset(filename);
+    auto access = std::make_shared<IdxDiskAccess>(db.get(), StringTree("access").write("disable_async", true));
+    if (!access->compact(nthreads))
+      ThrowException(args[0], "compact failed", filename);
+
+    return data;
+  }
+
+};
+
+///////////////////////////////////////////////////////////
+class ScanBlockPresence : public VisusConvert::Step
+{
+public:
+
+  //getHelp
+  virtual String getHelp(std::vector<String> args) override
+  {
+    std::ostringstream out;
+    out << args[0]
+      << " <filename.idx>" << std::endl;
+    return out.str();
+  }
+
+  //exec
+  virtual Array exec(Array data, std::vector<String> args) override
+  {
+    if (args.size() < 2)
+      ThrowException(args[0], "syntax error");
+
+    String filename = args[1];
+
+    auto db = LoadIdxDataset(filename);
+    auto access = std::make_shared<IdxDiskAccess>(db.get(), StringTree("access").write("disable_async", true));
+    if (!access->scanBlockPresence())
+      ThrowException(args[0], "scan failed", filename);
+
+    return data;
+  }
+
+};
+
+///////////////////////////////////////////////////////////
+class ScanBlockRanges : public VisusConvert::Step
+{
+public:
+
+  //getHelp
+  virtual String getHelp(std::vector<String> args) override
+  {
+    std::ostringstream out;
+    out << args[0]
+      << " <filename.idx>" << std::endl;
+    return out.str();
+  }
+
+  //exec
+  virtual Array exec(Array data, std::vector<String> args) override
+  {
+    if (args.size() < 2)
+      ThrowException(args[0], "syntax error");
+
+    String filename = args[1];
+
+    auto db = LoadIdxDataset(filename);
+    auto access = std::make_shared<IdxDiskAccess>(db.get(), StringTree("access").write("disable_async", true).write("direct_io", true));
+    if (!access->scanBlockRanges())
+      ThrowException(args[0], "scan failed", filename);
+
+    return data;
+  }
+
+};
+
+///////////////////////////////////////////////////////////
+class BenchmarkHzScatter : public VisusConvert::Step
+{
+public:
+
+  //getHelp
+  virtual String getHelp(std::vector<String> args) override
+  {
+    std::ostringstream out;
+    out << args[0]
+      << " <filename.idx>" << std::endl
+      << "   [--box <x1 x2 y1 y2 ...>]" << std::endl
+      << "   [--field <fieldname>]" << std::endl
+      << "   [--end-resolution <int>]" << std::endl
+      << "   [--repeat <int>]" << std::endl
+      << "Merges synthetic hzorder blocks into a box query (no I/O) with the scalar kernel, the scatter kernel and the scatter kernel replaying recorded spans" << std::endl;
+    return out.str();
+  }
+
+  //exec
+  virtual Array exec(Array data, std::vector<String> args) override
+  {
+    if (args.size() < 2)
+      ThrowException(args[0], "syntax error");
+
+    String filename = args[1];
+
+    auto db = LoadIdxDataset(filename);
+    if (!db)
+      ThrowException(args[0], "cannot load", filename);
+
+    auto logic_box = db->getLogicBox();
+    auto field = db->getField();
+    int end_resolution = db->getMaxResolution();
+    int repeat = 3;
+    for (int I = 2; I < (int)args.size(); I++)
+    {
+      if (args[I] == "--box")
+        logic_box = BoxNi::parseFromOldFormatString(db->getPointDim(), args[++I]);
+
+      else if (args[I] == "--field")
+        field = db->getField(args[++I]);
+
+      else if (args[I] == "--end-resolution")
+        end_resolution = cint(args[++I]);
+
+      else if (args[I] == "--repeat")
+        repeat = std::max(1, cint(args[++I]));
+    }
+
+    int bitsperblock = db->getDefaultBitsPerBlock();
+
+    auto createQuery = [&]() {
+      auto query = db->createBoxQuery(logic_box, field, db->getTime(), 'r');
+      query->end_resolutions = { end_resolution };
+      db->beginBoxQuery(query);
+      if (!query->isRunning() || !query->allocateBufferIfNeeded())
+        ThrowException(args[0], "cannot create query");
+      return query;
+    };
+
+    //synthetic blocks (each sample is different)
+    auto plan = db->createBoxQueryPlan(createQuery().get(), bitsperblock);
+    std::vector< SharedPtr<BlockQuery> > blocks;
+    for (auto blockid : plan->blocks)
+    {
+      auto block = db->createBlockQuery(blockid, field, db->getTime(), 'r');
+      if (!block->allocateBufferIfNeeded())
+        ThrowException(args[0], "cannot allocate block");
+      block->buffer.layout = "hzorder";
+      auto ptr = block->buffer.c_ptr();
+      for (Int64 I = 0, N = block->buffer.c_size(); I < N; I++)
+        ptr[I] = (Uint8)(blockid * 31 + I * 7);
+      blocks.push_back(block);
+    }
+
+    PrintInfo(args[0], "logic_box", logic_box, "dtype", field.dtype, "end_resolution", end_resolution, "nblocks", blocks.size());
+
+    Array expected;
+    for (String kernel : { "scalar", "scatter", "scatter+spans" })
+    {
+      //the scatter kernel needs a plan, spans are recorded only if the plan allows some memory
+      auto kernel_plan = kernel == "scalar" ? SharedPtr<IdxBoxQueryPlan>() : db->createBoxQueryPlan(createQuery().get(), bitsperblock, kernel == "scatter+spans" ? std::numeric_limits<Int64>::max() : 0);
+      if (kernel == "scatter+spans")
+      {
+        auto query = createQuery();
+        query->plan = kernel_plan;
+        for (auto block : blocks)
+          db->mergeBoxQueryWithBlockQuery(query, block);
+      }
+
+      double best = 0;
+      for (int R = 0; R < repeat; R++)
+      {
+        auto query = createQuery();
+        query->plan = kernel_plan;
+
+        auto t1 = Time::now();
+        for (auto block : blocks)
+          db->mergeBoxQueryWithBlockQuery(query, block);
+        double sec = t1.elapsedSec();
+        best = R == 0 ? sec : std::min(best, sec);
+
+        if (!expected)
+          expected = query->buffer;
+        else if (memcmp(expected.c_ptr(), query->buffer.c_ptr(), (size_t)expected.c_size()) != 0)
+          ThrowException(args[0], "kernel", kernel, "produced a different result");
+      }
+
+      //plain scatter must not replay spans, otherwise it measures the same kernel as scatter+spans
+      if (kernel == "scatter")
+      {
+        for (auto blockid : plan->blocks)
+        {
+          if (kernel_plan->getSpans(blockid))
+            ThrowException(args[0], "kernel", kernel, "recorded spans");
+        }
+      }
+
+      PrintInfo(args[0], "kernel", kernel, "best", best, "sec", "MB/sec", best > 0 ? (expected.c_size() / (1024.0 * 1024.0)) / best : 0.0);
+    }
+
+    return data;
+  }
+
+};
+
 } //namespace Private
 
 //////////////////////////////////////////////////////////////////////////////
@@ -602,6 +835,10 @@ VisusConvert::VisusConvert()
   addAction("resize", []() {return std::make_shared<ResizeData>(); });
   addAction("resample", []() {return std::make_shared<ResampleData>(); });
   addAction("get-component", []() {return std::make_shared<GetComponent>(); });
+  addAction("compact", []() {return std::make_shared<CompactIdx>(); });
+  addAction("scan-block-presence", []() {return std::make_shared<ScanBlockPresence>(); });
+  addAction("scan-block-ranges", []() {return std::make_shared<ScanBlockRanges>(); });
+  addAction("benchmark-hz-scatter", []() {return std::make_shared<BenchmarkHzScatter>(); });
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -41,11 +41,26 @@ For support : support@visus.net
 
 #include <Visus/Kernel.h>
 
+#include <atomic>
+#include <functional>
+#include <map>
+#include <mutex>
+
 namespace Visus {
 
 //////////////////////////////////////////////////////////////////////
+/*
+Cancellation token: all the copies share the same flag, which can be set and read from any thread.
+
+Hot loops should not test the flag for every sample: check it once per chunk, or use checkEvery.
+Callbacks are called when the flag becomes true, for example to wake up a blocked wait (see Semaphore::down(Aborted)).
+*/
 class VISUS_KERNEL_API Aborted 
 {
+#if !SWIG
+  class Inner;
+#endif
+
 public:
 
   VISUS_CLASS(Aborted)
@@ -56,40 +71,117 @@ public:
 
   //getAbortedId
   String getAbortedId() const {
-    return std::to_string((Int64)this->inner_value.get());
+    return std::to_string((Int64)this->inner.get());
   }
 
   //call operator
   bool operator()() const {
-    return *inner_value;
+    return inner->value.load(std::memory_order_acquire);
   }
 
-  //setTrue
-  void setTrue() {
-    *inner_value = true;
+  //setTrue (callbacks are called only when the flag changes)
+  void setTrue() 
+  {
+    std::lock_guard<std::recursive_mutex> lock(inner->lock);
+    if (inner->value.exchange(true))
+      return;
+
+    auto callbacks = inner->callbacks;
+    for (auto it : callbacks)
+      it.second();
   }
 
   //setFalse
   void setFalse() {
-    *inner_value = false;
+    inner->value = false;
   }
   
   //operator==
   bool operator==(Aborted& other) const {
-    return inner_value== other.inner_value;
+    return inner == other.inner;
   }
 
   //operator!=
   bool operator!=(Aborted& other) const {
-    return inner_value != other.inner_value;
+    return inner != other.inner;
+  }
+
+#if !SWIG
+
+  //addCallback (called by setTrue, or immediately if already aborted; it must be quick and must not block)
+  int addCallback(std::function<void()> fn)
+  {
+    std::lock_guard<std::recursive_mutex> lock(inner->lock);
+    int id = ++inner->last_id;
+    inner->callbacks[id] = fn;
+    if (inner->value)
+      fn();
+    return id;
+  }
+
+  //removeCallback (after it returns, the callback is not running and will not be called anymore)
+  void removeCallback(int id) 
+  {
+    std::lock_guard<std::recursive_mutex> lock(inner->lock);
+    inner->callbacks.erase(id);
+  }
+
+  //________________________________________________
+  //for hot loops: the flag is read at the first call, then once every N calls
+  //  auto check_aborted = aborted.checkEvery(4096);
+  //  for (...) { if (check_aborted()) return false; ... }
+  class CheckEvery
+  {
+  public:
+
+    //constructor
+    CheckEvery(const Aborted& aborted, Int64 N_) : inner(aborted.inner), N(std::max(N_, (Int64)1)) {
+    }
+
+    //call operator
+    bool operator()() 
+    {
+      if (--counter > 0)
+        return false;
+      counter = N;
+      return inner->value.load(std::memory_order_acquire);
+    }
+
+  private:
+
+    SharedPtr<Inner> inner;
+    Int64            N = 1;
+    Int64            counter = 1;
+
+  };
+
+  //checkEvery
+  CheckEvery checkEvery(Int64 N) const {
+    return CheckEvery(*this, N);
   }
 
+#endif
+
 private:
 
-  SharedPtr<bool> inner_value = std::make_shared<bool>(false);
+#if !SWIG
+  class Inner
+  {
+  public:
+    std::atomic<bool>                      value;
+    std::recursive_mutex                   lock;
+    int                                    last_id = 0;
+    std::map<int, std::function<void()> >  callbacks;
 
-};
+    //constructor
+    Inner() : value(false) {
+    }
+  };
+
+  SharedPtr<Inner> inner = std::make_shared<Inner>();
+#endif
 
+};
 
 } //namespace Visus
 
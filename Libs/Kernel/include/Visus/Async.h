@@ -168,6 +168,18 @@ public:
     return *(promise->value);
   }
 
+  //wait (false if aborted before the value is ready)
+  bool wait(Aborted aborted) const
+  {
+    if (!promise) { VisusAssert(false); return false; }
+
+    auto ready = std::make_shared<Semaphore>();
+    promise->when_ready([ready](Value) {
+      ready->up();
+    });
+    return ready->down(aborted) || is_ready();
+  }
+
   //get_promise
   SharedPtr< BasePromise<Value> > get_promise() const {
     return promise;
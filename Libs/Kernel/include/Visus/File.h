@@ -41,8 +41,10 @@ For support : support@visus.net
 
 #include <Visus/Kernel.h>
 #include <Visus/Path.h>
+#include <Visus/HeapMemory.h>
 
 #include <atomic>
+#include <functional>
 
 namespace Visus {
 
@@ -57,15 +59,17 @@ public:
   std::atomic<Int64> nopen;
   std::atomic<Int64> rbytes;
   std::atomic<Int64> wbytes;
+  std::atomic<Int64> nread;
+  std::atomic<Int64> nwrite;
 #endif
 
   //constructor
-  FileGlobalStats() : nopen(0), rbytes(0), wbytes(0){
+  FileGlobalStats() : nopen(0), rbytes(0), wbytes(0), nread(0), nwrite(0){
   }
 
   //resetStats
   void resetStats() {
-    nopen = rbytes = wbytes = 0;
+    nopen = rbytes = wbytes = nread = nwrite = 0;
   }
 
   //getReadBytes
@@ -83,6 +87,16 @@ public:
     return nopen;
   }
 
+  //getNumRead (i.e. number of read calls to the OS)
+  Int64 getNumRead() const {
+    return nread;
+  }
+
+  //getNumWrite (i.e. number of write calls to the OS)
+  Int64 getNumWrite() const {
+    return nwrite;
+  }
+
 };
 
 /////////////////////////////////////////////////////////////////////////
@@ -96,6 +110,29 @@ public:
     MustCreateFile=0x01
   };
 
+  //__________________________________________________________________
+#if !SWIG
+  class VISUS_KERNEL_API ReadRequest
+  {
+  public:
+
+    //file offset
+    Int64 pos = 0;
+
+    //(count,buffer) pairs filled in order with the bytes starting at pos
+    std::vector< std::pair<Int64, unsigned char*> > buffers;
+
+    //constructor
+    ReadRequest() {
+    }
+
+    //constructor
+    ReadRequest(Int64 pos_, Int64 count, unsigned char* buffer) : pos(pos_) {
+      buffers.push_back(std::make_pair(count, buffer));
+    }
+  };
+#endif
+
   //__________________________________________________________________
 #if !SWIG
   class VISUS_KERNEL_API Pimpl
@@ -139,6 +176,31 @@ public:
     //read (should be portable to 32 and 64 bit OS)
     virtual bool read(Int64 pos, Int64 count, unsigned char* buffer) = 0;
 
+    //readv (scatter contiguous bytes starting at pos into several buffers)
+    virtual bool readv(Int64 pos, const std::vector< std::pair<Int64, unsigned char*> >& buffers) {
+      for (auto it : buffers) {
+        if (!read(pos, it.first, it.second)) return false;
+        pos += it.first;
+      }
+      return true;
+    }
+
+    //map (return a view of the file without copying, null if not supported)
+    virtual SharedPtr<HeapMemory> map(Int64 pos, Int64 count) {
+      return SharedPtr<HeapMemory>();
+    }
+
+    //prefetch (hint that [pos,pos+count) will be read soon, false if not supported)
+    virtual bool prefetch(Int64 pos, Int64 count) {
+      return false;
+    }
+
+    //readBatch (done(index,ok) is called exactly once for each request, in completion order)
+    virtual void readBatch(const std::vector<ReadRequest>& requests, std::function<void(int, bool)> done) {
+      for (int I = 0; I < (int)requests.size(); I++)
+        done(I, readv(requests[I].pos, requests[I].buffers));
+    }
+
   protected:
 
     inline void onOpenEvent() {
@@ -146,10 +208,12 @@ public:
     }
 
     inline void onReadEvent(Int64 value) {
+      File::global_stats()->nread++;
       File::global_stats()->rbytes += value;
     }
 
     inline void onWriteEvent(Int64 value) {
+      File::global_stats()->nwrite++;
       File::global_stats()->wbytes += value;
     }
 
@@ -170,6 +234,39 @@ public:
     return &ret;
   }
 
+  //isIoUringAvailable (i.e. Linux kernel with io_uring enabled)
+  static bool isIoUringAvailable();
+
+  //enableIoUring (used from the next open, falls back to posix if io_uring is not available)
+  void enableIoUring(bool value = true) {
+    this->bIoUring = value;
+  }
+
+  //isIoUringEnabled
+  bool isIoUringEnabled() const {
+    return bIoUring;
+  }
+
+  //enableMemoryMapping (used from the next read-only open, see map())
+  void enableMemoryMapping(bool value = true) {
+    this->bMemoryMapped = value;
+  }
+
+  //isMemoryMappingEnabled
+  bool isMemoryMappingEnabled() const {
+    return bMemoryMapped;
+  }
+
+  //enableDirectIO (used from the next open, reads bypass the page cache and written pages are dropped from it; Linux only)
+  void enableDirectIO(bool value = true) {
+    this->bDirectIO = value;
+  }
+
+  //isDirectIOEnabled
+  bool isDirectIOEnabled() const {
+    return bDirectIO;
+  }
+
   //isOpen
   bool isOpen() const  {
     return pimpl ? true : false;
@@ -225,9 +322,39 @@ public:
     return pimpl ? pimpl->read(pos, count, buffer) : false;
   }
 
+  //readv (buffers are (count,buffer) pairs filled in order with the bytes starting at pos)
+  bool readv(Int64 pos, const std::vector< std::pair<Int64, unsigned char*> >& buffers) {
+    return pimpl ? pimpl->readv(pos, buffers) : false;
+  }
+
+  //map (zero copy view of [pos,pos+count) for memory mapped files, keeps the mapping alive even after close)
+  SharedPtr<HeapMemory> map(Int64 pos, Int64 count) {
+    return pimpl ? pimpl->map(pos, count) : SharedPtr<HeapMemory>();
+  }
+
+  //prefetch (asks the OS to start reading [pos,pos+count) in the background, does not wait)
+  bool prefetch(Int64 pos, Int64 count) {
+    return pimpl ? pimpl->prefetch(pos, count) : false;
+  }
+
+#if !SWIG
+  //readBatch (with io_uring all requests are in flight at the same time)
+  void readBatch(const std::vector<ReadRequest>& requests, std::function<void(int, bool)> done) 
+  {
+    if (pimpl)
+      return pimpl->readBatch(requests, done);
+
+    for (int I = 0; I < (int)requests.size(); I++)
+      done(I, false);
+  }
+#endif
+
 protected:
 
   UniquePtr<Pimpl> pimpl;
+  bool             bIoUring = false;
+  bool             bMemoryMapped = false;
+  bool             bDirectIO = false;
 
   //open
   bool open(String filename, String file_mode, Options options);
@@ -253,6 +380,12 @@ public:
   //mkdir/rmdir
   static bool createDirectory(Path path,bool bCreateParents=true);
   static bool removeDirectory(Path path);
+
+  //removeEmptyDirectory (fails if the directory is not empty)
+  static bool removeEmptyDirectory(Path path);
+
+  //listDirectory (names of files and directories inside the directory, without . and ..)
+  static std::vector<String> listDirectory(Path path);
   
   //return the size of the file
   static Int64 getFileSize(Path path);
@@ -263,6 +396,9 @@ public:
   //getTimeLastAccessed
   static Int64 getTimeLastAccessed(Path path);
 
+  //getFileVersion (changes whenever the file is rewritten, empty if the file does not exist)
+  static String getFileVersion(Path path);
+
   //special lock/unlock functions
   static void lock  (Path path);
   static void unlock(Path path);
@@ -80,6 +80,9 @@ public:
   //hasConstantValue
   bool hasConstantValue(Uint8 value) const;
 
+  //hasConstantSample (i.e. all the samples of sample_size bytes are equal to the first one)
+  bool hasConstantSample(Int64 sample_size) const;
+
   //isAllZero
   bool isAllZero() const {
     return hasConstantValue(0);
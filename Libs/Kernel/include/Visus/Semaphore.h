@@ -40,6 +40,7 @@ For support : support@visus.net
 #define __VISUS_SEMAPHORE_H__
 
 #include <Visus/Kernel.h>
+#include <Visus/Aborted.h>
 
 namespace Visus {
 
@@ -60,6 +61,9 @@ public:
   //return only if "number of resources" is not zero, otherwise wait
   void down();
 
+  //down (returns false without taking any resource if aborted while waiting)
+  bool down(Aborted aborted);
+
   //release one "resource"
   void up();
 
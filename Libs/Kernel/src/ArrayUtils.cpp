@@ -619,6 +619,9 @@ Array ArrayUtils::smartCast(Array src, DType dtype_, Aborted aborted)
   int m = dst.dtype.ncomponents();
   int ncomponents = std::min(m, n);
 
+  //per-sample loops below, check aborted every few thousands samples
+  auto check_aborted = aborted.checkEvery(4096);
+
   if (src.dtype.isVectorOf(DTypes::UINT16) && dst.dtype.isVectorOf(DTypes::UINT8))
   {
     for (int C = 0; C < ncomponents; C++)
@@ -631,7 +634,7 @@ Array ArrayUtils::smartCast(Array src, DType dtype_, Aborted aborted)
         max = *src_p;
         for (Int64 I = 0; I < totsamples; I++, src_p += n)
         {
-          if (aborted()) return Array();
+          if (check_aborted()) return Array();
           min = std::min(min, *src_p);
           max = std::max(max, *src_p);
         }
@@ -643,7 +646,7 @@ Array ArrayUtils::smartCast(Array src, DType dtype_, Aborted aborted)
         Uint8*  dst_p = ((Uint8*)dst.c_ptr()) + C;
         for (Int64 I = 0; I < totsamples; I++, src_p += n, dst_p += m)
         {
-          if (aborted()) return Array();
+          if (check_aborted()) return Array();
           *dst_p = (Uint8)(255.0*(*src_p - min) / (double)(max - min));
         }
       }
@@ -660,7 +663,7 @@ Array ArrayUtils::smartCast(Array src, DType dtype_, Aborted aborted)
       Float32* dst_p = ((Float32*)dst.c_ptr()) + C;
       for (Int64 I = 0; I < totsamples; I++, src_p += n, dst_p += m)
       {
-        if (aborted()) return Array();
+        if (check_aborted()) return Array();
         *dst_p = (*src_p) / 255.0f;
       }
     }
@@ -676,7 +679,7 @@ Array ArrayUtils::smartCast(Array src, DType dtype_, Aborted aborted)
       Float64* dst_p = ((Float64*)dst.c_ptr()) + C;
       for (Int64 I = 0; I < totsamples; I++, src_p += n, dst_p += m)
       {
-        if (aborted()) return Array();
+        if (check_aborted()) return Array();
         *dst_p = (*src_p) / 255.0;
       }
     }
@@ -692,7 +695,7 @@ Array ArrayUtils::smartCast(Array src, DType dtype_, Aborted aborted)
       Float64* dst_p = ((Float64*)dst.c_ptr()) + C;
       for (Int64 I = 0; I < totsamples; I++, src_p += n, dst_p += m)
       {
-        if (aborted()) return Array();
+        if (check_aborted()) return Array();
         *dst_p = *src_p;
       }
     }
@@ -710,7 +713,7 @@ Array ArrayUtils::smartCast(Array src, DType dtype_, Aborted aborted)
       Uint8*    dst_p = ((Uint8*)dst.c_ptr()) + C;
       for (Int64 I = 0; I < totsamples; I++, src_p += n, dst_p += m)
       {
-        if (aborted()) return Array();
+        if (check_aborted()) return Array();
         *dst_p = (Uint8)(255 * Utils::clamp((Float32)((*src_p) - range.from) / (Float32)(range.to - range.from), 0.0f, 1.0f));
       }
     }
@@ -728,7 +731,7 @@ Array ArrayUtils::smartCast(Array src, DType dtype_, Aborted aborted)
       Uint8*    dst_p = ((Uint8*)dst.c_ptr()) + C;
       for (Int64 I = 0; I < totsamples; I++, src_p += n, dst_p += m)
       {
-        if (aborted()) return Array();
+        if (check_aborted()) return Array();
         *dst_p = (Uint8)(255 * Utils::clamp((Float64)((*src_p) - range.from) / (Float64)(range.to - range.from), 0.0, 1.0));
       }
     }
@@ -42,6 +42,8 @@ For support : support@visus.net
 #include <Visus/Time.h>
 #include "osdep.hxx"
 
+#include <deque>
+
 namespace Visus {
 
 
@@ -103,6 +105,14 @@ public:
   //read
   virtual bool read(Int64 pos, Int64 tot, unsigned char* buffer) override;
 
+#if !WIN32 && !__APPLE__
+  //readv
+  virtual bool readv(Int64 pos, const std::vector< std::pair<Int64, unsigned char*> >& buffers) override;
+
+  //prefetch
+  virtual bool prefetch(Int64 pos, Int64 count) override;
+#endif
+
   //seek
   bool seek(Int64 value);
 
@@ -270,6 +280,206 @@ bool PosixFile::read(Int64 pos, Int64 tot, unsigned char* buffer)
 }
 
 
+#if !WIN32 && !__APPLE__
+/////////////////////////////////////////////////////////////////////
+bool PosixFile::readv(Int64 pos, const std::vector< std::pair<Int64, unsigned char*> >& buffers)
+{
+  if (!isOpen() || !can_read)
+    return false;
+
+  std::vector<struct iovec> iov;
+  for (auto it : buffers)
+  {
+    if (it.first < 0) return false;
+    if (!it.first) continue;
+    struct iovec item;
+    item.iov_base = it.second;
+    item.iov_len = (size_t)it.first;
+    iov.push_back(item);
+  }
+
+  //note: preadv does not change the file offset, so the cursor is still valid
+  for (int I = 0, N = (int)iov.size(); I < N;)
+  {
+    int chunk = std::min(N - I, IOV_MAX);
+    auto n = ::preadv(this->handle, &iov[I], chunk, pos);
+
+    if (n <= 0)
+      return false;
+
+    onReadEvent(n);
+    pos += n;
+
+    //skip what has been completely read, adjust any partial read
+    for (; I < N && n >= (Int64)iov[I].iov_len; I++)
+      n -= iov[I].iov_len;
+
+    if (n)
+    {
+      iov[I].iov_base = (char*)iov[I].iov_base + n;
+      iov[I].iov_len -= n;
+    }
+  }
+
+  return true;
+}
+
+/////////////////////////////////////////////////////////////////////
+bool PosixFile::prefetch(Int64 pos, Int64 count)
+{
+  if (!isOpen() || !can_read || pos < 0 || count <= 0)
+    return false;
+
+  return ::posix_fadvise(this->handle, (off_t)pos, (off_t)count, POSIX_FADV_WILLNEED) == 0;
+}
+
+#if defined(O_DIRECT)
+/////////////////////////////////////////////////////////////////////
+//reads use a second O_DIRECT handle with aligned bounce buffers, so they never go through the page cache
+//writes cannot use O_DIRECT (the file size would be rounded to the alignment), so written pages are flushed and dropped every few MB
+class DirectFile : public PosixFile
+{
+public:
+
+  enum 
+  {
+    Alignment = 4096
+  };
+
+  int   direct = -1;
+  Int64 unflushed = 0;
+
+  //constructor
+  DirectFile() {
+  }
+
+  //destructor
+  virtual ~DirectFile() {
+    close();
+  }
+
+  //open
+  virtual bool open(String filename, String file_mode, File::Options options) override
+  {
+    if (!PosixFile::open(filename, file_mode, options))
+      return false;
+
+    //fallback to the page cache if the file system does not support it (e.g. tmpfs)
+    if (can_read)
+      this->direct = ::open(filename.c_str(), O_RDONLY | O_DIRECT);
+
+    return true;
+  }
+
+  //close
+  virtual void close() override
+  {
+    if (direct != -1)
+    {
+      ::close(direct);
+      direct = -1;
+    }
+    dropWritten();
+    PosixFile::close();
+  }
+
+  //write
+  virtual bool write(Int64 pos, Int64 tot, const unsigned char* buffer) override
+  {
+    if (!PosixFile::write(pos, tot, buffer))
+      return false;
+
+    if ((unflushed += tot) >= 64 * 1024 * 1024)
+      dropWritten();
+
+    return true;
+  }
+
+  //read
+  virtual bool read(Int64 pos, Int64 tot, unsigned char* buffer) override {
+    return readv(pos, { std::make_pair(tot, buffer) });
+  }
+
+  //readv (one aligned read for the whole range)
+  virtual bool readv(Int64 pos, const std::vector< std::pair<Int64, unsigned char*> >& buffers) override
+  {
+    if (direct == -1)
+      return PosixFile::readv(pos, buffers);
+
+    if (!isOpen() || !can_read || pos < 0)
+      return false;
+
+    Int64 tot = 0;
+    for (auto it : buffers)
+    {
+      if (it.first < 0) return false;
+      tot += it.first;
+    }
+
+    if (!tot)
+      return true;
+
+    Int64 A = pos & ~((Int64)Alignment - 1);
+    Int64 B = (pos + tot + Alignment - 1) & ~((Int64)Alignment - 1);
+
+    HeapMemory bounce;
+    if (!bounce.resize(B - A + Alignment, __FILE__, __LINE__))
+      return false;
+
+    auto aligned = (unsigned char*)(((size_t)bounce.c_ptr() + Alignment - 1) & ~((size_t)Alignment - 1));
+
+    //the last block of the file can be short
+    Int64 done = 0;
+    while (A + done < pos + tot)
+    {
+      auto n = ::pread(direct, aligned + done, (size_t)(B - A - done), (off_t)(A + done));
+      if (n < 0)
+        return false;
+
+      if (n == 0)
+        break;
+
+      done += n;
+    }
+
+    if (A + done < pos + tot)
+      return false;
+
+    onReadEvent(tot);
+
+    auto src = aligned + (pos - A);
+    for (auto it : buffers)
+    {
+      memcpy(it.second, src, (size_t)it.first);
+      src += it.first;
+    }
+
+    return true;
+  }
+
+  //prefetch (would just fill the page cache)
+  virtual bool prefetch(Int64 pos, Int64 count) override {
+    return false;
+  }
+
+private:
+
+  //dropWritten
+  void dropWritten()
+  {
+    if (!isOpen() || !unflushed)
+      return;
+
+    ::fdatasync(this->handle);
+    ::posix_fadvise(this->handle, 0, 0, POSIX_FADV_DONTNEED);
+    unflushed = 0;
+  }
+
+};
+#endif //O_DIRECT
+
+#endif
+
 /////////////////////////////////////////////////////////////////////
 bool PosixFile::seek(Int64 value)
 {
@@ -314,23 +524,364 @@ String PosixFile::GetOpenErrorExplanation()
 }
 
 
+#if VISUS_IO_URING
+/////////////////////////////////////////////////////////////////////////////////////////
+class IoUring
+{
+public:
+
+  VISUS_NON_COPYABLE_CLASS(IoUring)
+
+  int      fd = -1;
+  unsigned entries = 0;
+  bool     busy = false;
+  bool     failed = false;
+
+  //user_data of the IORING_OP_ASYNC_CANCEL completions
+  static const Uint64 CancelUserData = (Uint64)-1;
+
+  //constructor
+  IoUring(unsigned value)
+  {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    this->fd = (int)syscall(__NR_io_uring_setup, value, &params);
+    if (this->fd < 0)
+      return;
+
+    bool bSingleMap = (params.features & IORING_FEAT_SINGLE_MMAP) ? true : false;
+    this->sq_size   = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    this->cq_size   = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    this->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    if (bSingleMap)
+      this->sq_size = this->cq_size = std::max(this->sq_size, this->cq_size);
+
+    this->sq_ptr = mmap(nullptr, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    this->cq_ptr = bSingleMap ? sq_ptr : mmap(nullptr, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    this->sqes   = (struct io_uring_sqe*)mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sq_ptr == MAP_FAILED || cq_ptr == MAP_FAILED || sqes == MAP_FAILED)
+      return;
+
+    this->sq_head  = (unsigned*)((char*)sq_ptr + params.sq_off.head);
+    this->sq_tail  = (unsigned*)((char*)sq_ptr + params.sq_off.tail);
+    this->sq_mask  = (unsigned*)((char*)sq_ptr + params.sq_off.ring_mask);
+    this->sq_array = (unsigned*)((char*)sq_ptr + params.sq_off.array);
+    this->cq_head  = (unsigned*)((char*)cq_ptr + params.cq_off.head);
+    this->cq_tail  = (unsigned*)((char*)cq_ptr + params.cq_off.tail);
+    this->cq_mask  = (unsigned*)((char*)cq_ptr + params.cq_off.ring_mask);
+    this->cqes     = (struct io_uring_cqe*)((char*)cq_ptr + params.cq_off.cqes);
+    this->entries  = params.sq_entries;
+  }
+
+  //destructor
+  ~IoUring()
+  {
+    if (sqes && sqes != MAP_FAILED) munmap(sqes, sqes_size);
+    if (cq_ptr && cq_ptr != MAP_FAILED && cq_ptr != sq_ptr) munmap(cq_ptr, cq_size);
+    if (sq_ptr && sq_ptr != MAP_FAILED) munmap(sq_ptr, sq_size);
+    if (fd >= 0) ::close(fd);
+  }
+
+  //valid
+  bool valid() const {
+    return fd >= 0 && entries > 0;
+  }
+
+  //getThreadInstance (one ring for each thread, so no locking is needed; a failed ring is replaced)
+  static IoUring* getThreadInstance()
+  {
+    static thread_local UniquePtr<IoUring> ret;
+    if (!ret || (ret->failed && !ret->busy))
+      ret.reset(new IoUring(256));
+    return ret->valid() ? ret.get() : nullptr;
+  }
+
+  //push (caller must make sure there is space i.e. no more than entries in flight)
+  void push(int handle, Int64 pos, struct iovec* iov, int niov, Uint64 user_data)
+  {
+    unsigned tail  = *sq_tail;
+    unsigned index = tail & *sq_mask;
+    auto sqe = &sqes[index];
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    sqe->opcode    = IORING_OP_READV;
+    sqe->fd        = handle;
+    sqe->off       = (Uint64)pos;
+    sqe->addr      = (Uint64)(uintptr_t)iov;
+    sqe->len       = (unsigned)niov;
+    sqe->user_data = user_data;
+    sq_array[index] = index;
+    __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+  }
+
+  //pushCancel (caller must make sure there is space)
+  void pushCancel(Uint64 user_data)
+  {
+    unsigned tail  = *sq_tail;
+    unsigned index = tail & *sq_mask;
+    auto sqe = &sqes[index];
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    sqe->opcode    = IORING_OP_ASYNC_CANCEL;
+    sqe->fd        = -1;
+    sqe->addr      = user_data;
+    sqe->user_data = CancelUserData;
+    sq_array[index] = index;
+    __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+  }
+
+  //discard (drops the entries not consumed by the kernel yet, returns how many)
+  int discard()
+  {
+    unsigned head = __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+    int ret = (int)(*sq_tail - head);
+    __atomic_store_n(sq_tail, head, __ATOMIC_RELEASE);
+    return ret;
+  }
+
+  //enter (submit and wait for at least min_complete completions)
+  int enter(unsigned to_submit, unsigned min_complete = 1) {
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, min_complete ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+  }
+
+  //pop
+  bool pop(Uint64& user_data, int& res)
+  {
+    unsigned head = *cq_head;
+    if (head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE))
+      return false;
+
+    auto cqe = &cqes[head & *cq_mask];
+    user_data = cqe->user_data;
+    res       = cqe->res;
+    __atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+    return true;
+  }
+
+private:
+
+  void*                 sq_ptr = nullptr;
+  void*                 cq_ptr = nullptr;
+  size_t                sq_size = 0, cq_size = 0, sqes_size = 0;
+  unsigned              *sq_head = nullptr, *sq_tail = nullptr, *sq_mask = nullptr, *sq_array = nullptr;
+  unsigned              *cq_head = nullptr, *cq_tail = nullptr, *cq_mask = nullptr;
+  struct io_uring_sqe*  sqes = nullptr;
+  struct io_uring_cqe*  cqes = nullptr;
+
+};
+
+
+/////////////////////////////////////////////////////////////////////////////////////////
+class IoUringFile : public PosixFile
+{
+public:
+
+  //readBatch
+  virtual void readBatch(const std::vector<File::ReadRequest>& requests, std::function<void(int, bool)> done) override;
+
+private:
+
+  //cancelAndReap (after a io_uring_enter failure the kernel could still write into the buffers, must wait for all the submitted reads)
+  void cancelAndReap(IoUring* ring, std::vector<bool>& running, int inflight);
+
+};
+
+/////////////////////////////////////////////////////////////////////
+void IoUringFile::cancelAndReap(IoUring* ring, std::vector<bool>& running, int inflight)
+{
+  int ncancel = 0;
+  for (int I = 0; I < (int)running.size() && ncancel < (int)ring->entries; I++)
+  {
+    if (running[I])
+    {
+      ring->pushCancel((Uint64)I);
+      ncancel++;
+    }
+  }
+
+  int submitted = ncancel ? ring->enter(ncancel, 0) : 0;
+  if (submitted < 0)
+    submitted = 0;
+  ring->discard();
+
+  //completions are posted to the ring even if io_uring_enter keeps failing
+  for (int outstanding = inflight + submitted; outstanding > 0; )
+  {
+    Uint64 user_data; int res;
+    if (!ring->pop(user_data, res))
+    {
+      if (ring->enter(0, 1) < 0)
+        Thread::sleep(1);
+      continue;
+    }
+
+    outstanding--;
+    if (user_data != IoUring::CancelUserData)
+      running[(int)user_data] = false;
+  }
+}
+
+/////////////////////////////////////////////////////////////////////
+void IoUringFile::readBatch(const std::vector<File::ReadRequest>& requests, std::function<void(int, bool)> done)
+{
+  auto ring = IoUring::getThreadInstance();
+
+  //blocking reads if io_uring is not available or for re-entrant calls (i.e. from a done callback)
+  if (!isOpen() || !can_read || !ring || ring->busy)
+    return PosixFile::readBatch(requests, done);
+
+  int N = (int)requests.size();
+
+  //iovecs of request I are in [first[I],last[I]) 
+  std::vector<struct iovec> iov;
+  std::vector<int> first(N), last(N);
+  std::vector<Int64> pos(N);
+  std::deque<int> pending, too_big;
+  for (int I = 0; I < N; I++)
+  {
+    pos[I] = requests[I].pos;
+    first[I] = (int)iov.size();
+    for (auto it : requests[I].buffers)
+    {
+      if (it.first <= 0) continue;
+      struct iovec item;
+      item.iov_base = it.second;
+      item.iov_len = (size_t)it.first;
+      iov.push_back(item);
+    }
+    last[I] = (int)iov.size();
+
+    if (first[I] == last[I])
+      done(I, true);
+    else if (last[I] - first[I] > IOV_MAX)
+      too_big.push_back(I);
+    else
+      pending.push_back(I);
+  }
+
+  ring->busy = true;
+
+  std::vector<bool> running(N, false), finished(N, false);
+  int inflight = 0, unsubmitted = 0;
+  while (!pending.empty() || inflight)
+  {
+    while (!pending.empty() && inflight < (int)ring->entries)
+    {
+      int I = pending.front(); pending.pop_front();
+      ring->push(this->handle, pos[I], &iov[first[I]], last[I] - first[I], (Uint64)I);
+      running[I] = true;
+      inflight++;
+      unsubmitted++;
+    }
+
+    int submitted = ring->enter(unsubmitted);
+    if (submitted < 0)
+    {
+      if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+        continue;
+
+      //do not throw, the kernel could still write into the buffers: cancel/reap what is in flight and use readv for everything not finished
+      PrintWarning("io_uring_enter failed", errno, "falling back to readv");
+      inflight -= ring->discard();
+      cancelAndReap(ring, running, inflight);
+      ring->failed = true;
+      ring->busy = false;
+
+      for (int I = 0; I < N; I++)
+      {
+        if (!finished[I] && first[I] != last[I] && std::find(too_big.begin(), too_big.end(), I) == too_big.end())
+          done(I, readv(requests[I].pos, requests[I].buffers));
+      }
+
+      for (auto I : too_big)
+        done(I, readv(requests[I].pos, requests[I].buffers));
+      return;
+    }
+    unsubmitted -= submitted;
+
+    Uint64 user_data; int res;
+    while (ring->pop(user_data, res))
+    {
+      inflight--;
+      int I = (int)user_data;
+      running[I] = false;
+
+      if (res == -EINTR || res == -EAGAIN)
+      {
+        pending.push_front(I);
+        continue;
+      }
+
+      if (res <= 0)
+      {
+        finished[I] = true;
+        done(I, false);
+        continue;
+      }
+
+      onReadEvent(res);
+      pos[I] += res;
+
+      //skip what has been completely read, adjust any partial read
+      for (; first[I] < last[I] && (size_t)res >= iov[first[I]].iov_len; first[I]++)
+        res -= (int)iov[first[I]].iov_len;
+
+      if (first[I] == last[I])
+      {
+        finished[I] = true;
+        done(I, true);
+      }
+      else
+      {
+        iov[first[I]].iov_base = (char*)iov[first[I]].iov_base + res;
+        iov[first[I]].iov_len -= res;
+        pending.push_front(I);
+      }
+    }
+  }
+
+  ring->busy = false;
+
+  for (auto I : too_big)
+    done(I, readv(requests[I].pos, requests[I].buffers));
+}
+#endif //VISUS_IO_URING
+
+
 /////////////////////////////////////////////////////////////////////////////////////////
 class MemoryMappedFile : public File::Pimpl
 {
 public:
 
+  //_________________________________________________
+  class Mapping
+  {
+  public:
+
+    VISUS_NON_COPYABLE_CLASS(Mapping)
+
 #if WIN32
-  void* file = nullptr;
-  void* mapping = nullptr;
+    void* file = INVALID_HANDLE_VALUE;
+    void* mapping = nullptr;
 #else
-  int fd = -1;
+    int fd = -1;
 #endif
 
-  bool        can_read = false;
-  bool        can_write = false;
-  String      filename;
-  Int64       nbytes = 0;
-  char* mem = nullptr;
+    Int64 nbytes = 0;
+    char* mem = nullptr;
+
+    //constructor
+    Mapping() {
+    }
+
+    //destructor
+    ~Mapping();
+  };
+
+  bool               can_read = false;
+  bool               can_write = false;
+  String             filename;
+
+  //shared with the views returned by map(), so the memory stays valid after close()
+  SharedPtr<Mapping> mapping;
 
   //constructor
   MemoryMappedFile() {
@@ -343,7 +894,7 @@ public:
 
   //isOpen
   virtual bool isOpen() const override {
-    return mem != nullptr;
+    return mapping ? true : false;
   }
 
   //canRead
@@ -369,7 +920,7 @@ public:
 
   //size
   virtual Int64 size() override {
-    return nbytes;
+    return mapping ? mapping->nbytes : 0;
   }
 
   //write  
@@ -378,9 +929,36 @@ public:
   //read
   virtual bool read(Int64 pos, Int64 tot, unsigned char* buffer) override;
 
+  //map
+  virtual SharedPtr<HeapMemory> map(Int64 pos, Int64 tot) override;
+
 };
 
 
+/////////////////////////////////////////////////////////////////////
+MemoryMappedFile::Mapping::~Mapping()
+{
+#if WIN32 
+  {
+    if (mem)
+      UnmapViewOfFile(mem);
+
+    if (mapping)
+      CloseHandle(mapping);
+
+    if (file != INVALID_HANDLE_VALUE)
+      CloseHandle(file);
+  }
+#else
+  {
+    if (mem)
+      munmap(mem, nbytes);
+
+    if (fd != -1)
+      ::close(fd);
+  }
+#endif
+}
 
 
 /////////////////////////////////////////////////////////////////////
@@ -396,51 +974,50 @@ bool MemoryMappedFile::open(String filename, String file_mode, File::Options opt
     return false;
   }
 
+  auto mapping = std::make_shared<Mapping>();
+
 #if WIN32 
   {
-    this->file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    mapping->file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
 
-    if (file == INVALID_HANDLE_VALUE) {
-      close();
+    if (mapping->file == INVALID_HANDLE_VALUE)
       return false;
-    }
 
-    this->nbytes = GetFileSize(file, nullptr);
-    this->mapping = CreateFileMapping(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(mapping->file, &size))
+      return false;
 
-    if (mapping == nullptr) {
-      close();
+    mapping->nbytes = size.QuadPart;
+    mapping->mapping = CreateFileMapping(mapping->file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+
+    if (mapping->mapping == nullptr)
       return false;
-    }
 
-    this->mem = (char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    mapping->mem = (char*)MapViewOfFile(mapping->mapping, FILE_MAP_COPY, 0, 0, 0);
   }
 #else
   {
-    this->fd = ::open(filename.c_str(), O_RDONLY);
-    if (this->fd == -1) {
-      close();
+    mapping->fd = ::open(filename.c_str(), O_RDONLY);
+    if (mapping->fd == -1)
       return false;
-    }
 
     struct stat sb;
-    if (fstat(fd, &sb) == -1) {
-      close();
+    if (fstat(mapping->fd, &sb) == -1 || sb.st_size <= 0)
       return false;
-    }
 
-    this->nbytes = sb.st_size;
-    this->mem = (char*)mmap(nullptr, nbytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    //private copy-on-write pages: views can be modified without touching the file
+    mapping->nbytes = sb.st_size;
+    mapping->mem = (char*)mmap(nullptr, mapping->nbytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, mapping->fd, 0);
+    if (mapping->mem == (char*)MAP_FAILED)
+      mapping->mem = nullptr;
   }
 #endif
 
-  if (!mem) {
-    close();
+  if (!mapping->mem)
     return false;
-  }
-
 
   onOpenEvent();
+  this->mapping = mapping;
   this->filename = filename;
   this->can_read = file_mode.find("r") != String::npos;
   this->can_write = file_mode.find("w") != String::npos;
@@ -453,37 +1030,9 @@ void MemoryMappedFile::close()
   if (!isOpen())
     return;
 
-#if WIN32 
-  {
-    if (mem)
-      UnmapViewOfFile(mem);
-
-    if (mapping)
-      CloseHandle(mapping);
-
-    if (file != INVALID_HANDLE_VALUE)
-      CloseHandle(file);
-
-    mapping = nullptr;
-    file = INVALID_HANDLE_VALUE;
-  }
-#else
-  {
-    if (mem)
-      munmap(mem, nbytes);
-
-    if (fd != -1)
-    {
-      ::close(fd);
-      fd = -1;
-    }
-  }
-#endif
-
+  this->mapping.reset();
   this->can_read = false;
   this->can_write = false;
-  this->nbytes = 0;
-  this->mem = nullptr;
   this->filename = "";
 }
 
@@ -492,10 +1041,10 @@ void MemoryMappedFile::close()
 /////////////////////////////////////////////////////////////////////
 bool MemoryMappedFile::write(Int64 pos, Int64 tot, const unsigned char* buffer) 
 {
-  if (!isOpen() || (pos + tot) > this->nbytes)
+  if (!isOpen() || (pos + tot) > mapping->nbytes)
     return false;
 
-  memcpy(mem + pos, buffer, (size_t)tot);
+  memcpy(mapping->mem + pos, buffer, (size_t)tot);
   onWriteEvent(tot);
   return true;
 }
@@ -503,14 +1052,27 @@ bool MemoryMappedFile::write(Int64 pos, Int64 tot, const unsigned char* buffer)
 /////////////////////////////////////////////////////////////////////
 bool MemoryMappedFile::read(Int64 pos, Int64 tot, unsigned char* buffer) 
 {
-  if (!isOpen() || (pos + tot) > this->nbytes)
+  if (!isOpen() || pos < 0 || (pos + tot) > mapping->nbytes)
     return false;
 
-  memcpy(buffer, mem + pos, (size_t)tot);
+  memcpy(buffer, mapping->mem + pos, (size_t)tot);
   onReadEvent(tot);
   return true;
 }
 
+/////////////////////////////////////////////////////////////////////
+SharedPtr<HeapMemory> MemoryMappedFile::map(Int64 pos, Int64 tot)
+{
+  if (!isOpen() || pos < 0 || tot <= 0 || (pos + tot) > mapping->nbytes)
+    return SharedPtr<HeapMemory>();
+
+  //the deleter keeps the mapping alive as long as the view exists
+  auto view = HeapMemory::createUnmanaged(mapping->mem + pos, tot);
+  auto mapping = this->mapping;
+  onReadEvent(tot);
+  return SharedPtr<HeapMemory>(view.get(), [view, mapping](HeapMemory*) {});
+}
+
 
 /////////////////////////////////////////////////////////////////////////////////////////
 #if WIN32
@@ -752,6 +1314,17 @@ bool Win32File::seek(Int64 value)
 
 
 
+/////////////////////////////////////////////////////////////////////////
+bool File::isIoUringAvailable()
+{
+#if VISUS_IO_URING
+  static bool ret = IoUring(1).valid();
+  return ret;
+#else
+  return false;
+#endif
+}
+
 /////////////////////////////////////////////////////////////////////////
 bool File::open(String filename, String file_mode, Options options)
 {
@@ -760,7 +1333,25 @@ bool File::open(String filename, String file_mode, Options options)
   //NOTE fopen/fclose is even slower than _open/_close
   //pimpl.reset(new Win32File()); //don't see any advantage using Win32File
   //pimpl.reset(new MemoryMappedFile()); THIS IS THE SLOWEST
-  pimpl.reset(new PosixFile());
+  //memory mapping is only for reading, fallback to the other implementations if it fails (e.g. empty file)
+  if (bMemoryMapped && !bDirectIO && file_mode == "r" && !(options & MustCreateFile))
+  {
+    pimpl.reset(new MemoryMappedFile());
+    if (pimpl->open(filename, file_mode, options))
+      return true;
+  }
+
+#if !WIN32 && !__APPLE__ && defined(O_DIRECT)
+  if (bDirectIO)
+    pimpl.reset(new DirectFile());
+  else
+#endif
+#if VISUS_IO_URING
+  if (bIoUring && isIoUringAvailable())
+    pimpl.reset(new IoUringFile());
+  else
+#endif
+    pimpl.reset(new PosixFile());
 
   if (!pimpl->open(filename, file_mode, options)) {
     pimpl.reset();
@@ -844,6 +1435,35 @@ Int64 FileUtils::getTimeLastModified(Path path)
   return static_cast<Int64>(status.st_mtime);
 }
 
+/////////////////////////////////////////////////////////////////////////
+String FileUtils::getFileVersion(Path path)
+{
+  if (path.empty()) 
+    return "";
+
+  String fullpath=path.toString();
+
+  struct Stat64 status;
+  if (Stat64(fullpath.c_str(), &status) != 0)
+    return "";
+
+  //seconds are not enough, a same-size rewrite can happen in the same second
+  Int64 inode=0;
+  Int64 mtime=static_cast<Int64>(status.st_mtime)*1000000000;
+  Int64 ctime=static_cast<Int64>(status.st_ctime)*1000000000;
+#if __APPLE__
+  inode=static_cast<Int64>(status.st_ino);
+  mtime+=status.st_mtimespec.tv_nsec;
+  ctime+=status.st_ctimespec.tv_nsec;
+#elif !WIN32
+  inode=static_cast<Int64>(status.st_ino);
+  mtime+=status.st_mtim.tv_nsec;
+  ctime+=status.st_ctim.tv_nsec;
+#endif
+
+  return std::to_string((Int64)status.st_size) + ":" + std::to_string(inode) + ":" + std::to_string(mtime) + ":" + std::to_string(ctime);
+}
+
 /////////////////////////////////////////////////////////////////////////
 Int64 FileUtils::getTimeLastAccessed(Path path)
 {
@@ -898,6 +1518,24 @@ bool FileUtils::removeDirectory(Path path)
   return osdep::removeDirectory(fullpath);
 }
 
+/////////////////////////////////////////////////////////////////////////
+bool FileUtils::removeEmptyDirectory(Path path)
+{
+  if (path.empty()) 
+    return false;
+
+  return osdep::removeEmptyDirectory(path.toString());
+}
+
+/////////////////////////////////////////////////////////////////////////
+std::vector<String> FileUtils::listDirectory(Path path)
+{
+  if (path.empty()) 
+    return std::vector<String>();
+
+  return osdep::listDirectory(path.toString());
+}
+
 /////////////////////////////////////////////////////////////////////////
 bool FileUtils::touch(Path path)
 {
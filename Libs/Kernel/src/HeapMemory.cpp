@@ -123,6 +123,19 @@ bool HeapMemory::hasConstantValue(Uint8 value) const
     return buf[0]== value && memcmp(buf, buf + 1, (size_t)size - 1)==0;
 }
 
+////////////////////////////////////////////////////////
+bool HeapMemory::hasConstantSample(Int64 sample_size) const
+{
+  const Uint8* buf  = this->c_ptr();
+  Int64        size = this->c_size();
+  if (sample_size <= 0 || size % sample_size)
+    return false;
+  else if (size <= sample_size)
+    return true;
+  else
+    return memcmp(buf, buf + sample_size, (size_t)(size - sample_size))==0; //i.e. buf[I]==buf[I+sample_size] for all I
+}
+
 
 ////////////////////////////////////////////////////////////////////////////////////////
 bool HeapMemory::myRealloc(Int64 new_m,const char* file,int line)
@@ -59,13 +59,16 @@ struct ComputeHistogramOp
 
     auto samples=GetComponentSamples<Sample>(src,C);
 
-    int offset=0;
-    for (auto P = ForEachPoint(samples.dims); !P.end(); P.next(), offset++)
+    //check aborted once per chunk, not once per sample
+    const Int64 ChunkSize = 64 * 1024;
+    for (Int64 offset = 0; offset < Tot; offset += ChunkSize)
     {
       if (aborted()) 
         return false;
 
-      dst.incrementBin(dst.findBin((double)samples[offset]));
+      Int64 end = std::min(Tot, offset + ChunkSize);
+      for (Int64 I = offset; I < end; I++)
+        dst.incrementBin(dst.findBin((double)samples[I]));
     }
 
     dst.finilize();
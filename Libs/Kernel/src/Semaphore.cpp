@@ -208,6 +208,19 @@ void Semaphore::down(){
   pimpl->down();
 }
 
+bool Semaphore::down(Aborted aborted)
+{
+  //the callback wakes me up adding one resource, that compensates the one taken
+  bool bWokenUp = false;
+  int id = aborted.addCallback([this, &bWokenUp]() {
+    bWokenUp = true;
+    pimpl->up();
+  });
+  pimpl->down();
+  aborted.removeCallback(id);
+  return !bWokenUp;
+}
+
 void Semaphore::up(){
   pimpl->up();
 }
@@ -82,6 +82,7 @@ For support : support@visus.net
 	#include <unistd.h>
 	#include <signal.h>
 	#include <dlfcn.h>
+	#include <dirent.h>
 	#include <errno.h>
 	#include <pwd.h>
 	#include <netdb.h> 
@@ -129,6 +130,7 @@ For support : support@visus.net
 	
 	#include <semaphore.h>
 	#include <errno.h>
+	#include <dirent.h>
 	#include <unistd.h>
 	#include <limits.h>
 	#include <dlfcn.h>
@@ -146,9 +148,20 @@ For support : support@visus.net
 	#include <sys/types.h>
 	#include <sys/ioctl.h>
 	#include <sys/time.h>
+	#include <sys/uio.h>
 	
 	#include <arpa/inet.h>
 	#include <netinet/tcp.h>
+
+	#if defined(__has_include)
+		#if __has_include(<linux/io_uring.h>)
+			#include <linux/io_uring.h>
+			#include <sys/syscall.h>
+			#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) && defined(IORING_FEAT_SUBMIT_STABLE)
+				#define VISUS_IO_URING 1
+			#endif
+		#endif
+	#endif
 	
 	#define getIpCat(__value__)    __value__
 	#define closesocket(socketref) ::close(socketref)
@@ -361,6 +374,46 @@ public:
 		return ::system(cmd.c_str()) == 0 || ::system(cmd.c_str()) == 0; //try 2 times
 	}  
 
+  //removeEmptyDirectory
+  static bool removeEmptyDirectory(String value)
+	{
+	#if WIN32 
+	  return RemoveDirectory(TEXT(value.c_str())) != 0;
+	#else
+	  return ::rmdir(value.c_str()) == 0;
+	#endif
+	}  
+
+  //listDirectory
+  static std::vector<String> listDirectory(String value)
+	{
+	  std::vector<String> ret;
+	#if WIN32 
+	  WIN32_FIND_DATA data;
+	  HANDLE handle = FindFirstFile(TEXT((value + "\\*").c_str()), &data);
+	  if (handle == INVALID_HANDLE_VALUE)
+	    return ret;
+	  do {
+	    String name = data.cFileName;
+	    if (name != "." && name != "..")
+	      ret.push_back(name);
+	  } while (FindNextFile(handle, &data));
+	  FindClose(handle);
+	#else
+	  DIR* dir = ::opendir(value.c_str());
+	  if (!dir)
+	    return ret;
+	  while (struct dirent* entry = ::readdir(dir))
+	  {
+	    String name = entry->d_name;
+	    if (name != "." && name != "..")
+	      ret.push_back(name);
+	  }
+	  ::closedir(dir);
+	#endif
+	  return ret;
+	}  
+
   //createLink
   static bool createLink(String existing_file, String new_file)
 	{
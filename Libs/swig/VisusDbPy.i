@@ -14,6 +14,7 @@
 #include <Visus/IdxFile.h>
 #include <Visus/IdxDataset.h>
 #include <Visus/IdxDiskAccess.h>
+#include <Visus/IdxBoxQueryStream.h>
 #include <Visus/IdxMultipleDataset.h>
 #include <Visus/GoogleMapsDataset.h>
 #include <Visus/VisusConvert.h>
@@ -69,6 +70,8 @@ def LoadDataset(url):
 %include <Visus/Query.h>
 %include <Visus/BlockQuery.h>
 %include <Visus/BoxQuery.h>
+%template(VectorBoxQuery) std::vector< std::shared_ptr<Visus::BoxQuery> >;
+%template(VectorBoxQueryCost) std::vector<Visus::BoxQueryCost>;
 %include <Visus/PointQuery.h>
 %include <Visus/Query.h>
 %include <Visus/DatasetBitmask.h>
@@ -79,6 +82,7 @@ def LoadDataset(url):
 %include <Visus/IdxFile.h>
 %include <Visus/IdxDataset.h>
 %include <Visus/IdxDiskAccess.h>
+%include <Visus/IdxBoxQueryStream.h>
 %include <Visus/IdxMultipleDataset.h>
 %include <Visus/VisusConvert.h>
 
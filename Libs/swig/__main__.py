@@ -353,10 +353,11 @@ def CompressDataset(args):
 	parser = argparse.ArgumentParser(description="compress dataset")
 	parser.add_argument("--dataset"       , type=str,   help="dataset",     required=True)
 	parser.add_argument("--compression"   , type=str,   help="compression", required=True)
+	parser.add_argument("--nthreads"      , type=int,   help="number of files compressed in parallel", required=False, default=0)
 	args = parser.parse_args(args)
 
 	db=LoadDataset(args.dataset);Assert(db)
-	Assert(db.compressDataset([args.compression]))
+	db.compressDataset([args.compression], Array(), args.nthreads)
 
 
 # ////////////////////////////////////////////////
@@ -463,7 +464,7 @@ def Main(args):
 		CopyDataset(action_args)
 		sys.exit(0)
 
-	# -m OpenVisus compress-dataset --dataset "D:\GoogleSci\visus_dataset\cat256\visus0.idx" --compression zip
+	# -m OpenVisus compress-dataset --dataset "D:\GoogleSci\visus_dataset\cat256\visus0.idx" --compression zip [--nthreads 8]
 	if action=="compress-dataset":
 		CompressDataset(action_args)
 		sys.exit(0)
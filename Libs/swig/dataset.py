@@ -185,7 +185,7 @@ class PyDataset(object):
 		return write_block.ok()
 
 	# read
-	def read(self, logic_box=None, x=None, y=None, z=None, time=None, field=None, num_refinements=1, quality=0, max_resolution=None, disable_filters=False, access=None):
+	def read(self, logic_box=None, x=None, y=None, z=None, time=None, field=None, num_refinements=1, quality=0, max_resolution=None, disable_filters=False, access=None, tile_size=None, max_memory=0):
 		"""
 		db=PyDataset.Load(url)
 		
@@ -199,6 +199,11 @@ class PyDataset(object):
 		for data in db.read(z=[512,513],num_refinements=3):
 			print(data)
 
+		# example of streaming a region too big for memory, tile by tile (tile_size is in samples, x,y,z order)
+		# filters need the samples outside the tile, so a field with a filter can be streamed only with disable_filters=True
+		for (p1,p2),data in db.read(tile_size=[1024,1024,64],max_memory=1024*1024*1024):
+			print(p1,p2,data.shape)
+
 		"""
 		
 		pdim=self.getPointDim()
@@ -259,6 +264,22 @@ class PyDataset(object):
 				yield data
 				self.db.nextBoxQuery(query)	
 
+		def WithTiles():
+			Assert(query.end_resolutions.size()==1) # streaming does not support refinements
+			stream=IdxBoxQueryStream(IdxDataset.castFrom(self.db), access, query, PointNi(tile_size if tile_size else []), max_memory)
+			if query.failed():
+				raise Exception("query error {0}".format(query.errormsg))
+			while stream.next():
+				box=stream.getLogicBox()
+				# the tile buffer is released by the next stream.next()
+				data=Array.toNumPy(stream.getBuffer(), bShareMem=False)
+				yield ([box.p1[I] for I in range(pdim)],[box.p2[I] for I in range(pdim)]),data
+			if query.failed():
+				raise Exception("query error {0}".format(query.errormsg))
+
+		if tile_size is not None or max_memory:
+			return WithTiles()
+
 		return NoGenerator() if query.end_resolutions.size()==1 else WithGenerator()
 			
 
@@ -126,11 +126,11 @@ def ReadIdxBlockQuery(filename):
 	del access
 
 # ////////////////////////////////////////////////////////////////
-def ReadIdxBoxQuery(filename, dims):
+def ReadIdxBoxQuery(filename, dims, coalesce_reads=True):
 	db=LoadDataset(filename)
 	DIMS=db.getLogicSize()
-	access = IdxDiskAccess.create(db)
-	access.disableAsync()
+	# coalesce_reads='false' means one read call for each block (i.e. old behaviour)
+	access = db.createAccess(StringTree.fromString("<access type='disk' disable_async='true' coalesce_reads='{}' />".format("true" if coalesce_reads else "false")))
 	access.beginRead()
 	samplesize=db.getField().dtype.getByteSize()
 	try:
@@ -152,15 +152,16 @@ def ReadIdxBoxQuery(filename, dims):
 # ////////////////////////////////////////////////////////////////
 def TimeIt(name, gen, max_seconds=60):
 	user=next(gen) # skip any headers (open/close file)
-	USER, DISK, NCALLS, T1=0,0,0,Time.now()
+	USER, DISK, NREAD, NCALLS, T1=0,0,0,0,Time.now()
 	while T1.elapsedSec()<max_seconds:
 		File.global_stats().resetStats()
 		user=next(gen)
 		USER+=user
 		DISK+=File.global_stats().getReadBytes()
+		NREAD+=File.global_stats().getNumRead()
 		NCALLS+=1
 	SEC=T1.elapsedSec()
-	print(name,"{:0.2f}".format(USER/(SEC*MB)),"\t{:0.2f}".format(DISK/(SEC*MB)),"\t{:0.2f}".format(DISK/USER),"NCALLS",NCALLS)
+	print(name,"{:0.2f}".format(USER/(SEC*MB)),"\t{:0.2f}".format(DISK/(SEC*MB)),"\t{:0.2f}".format(DISK/USER),"NCALLS",NCALLS,"NREAD/CALL","{:0.2f}".format(NREAD/NCALLS))
 
 # ////////////////////////////////////////////////////////////////
 def Main():
@@ -185,6 +186,11 @@ def Main():
 		for dims in [(32,64,64), (32,32,64), (32,32,32), (16,32,32), (16,16,32)]: # 128k...8k
 			TimeIt(filename+"-BoxQuery{:03d}k".format(int(dims[0]*dims[1]*dims[2]/1024)),  ReadIdxBoxQuery(filename, dims))
 
+		# fullres box touching many blocks, with and without coalescing of nearby block reads
+		for coalesce_reads in (True, False):
+			dims=(256,256,256)
+			TimeIt(filename+"-BoxQuery{:03d}M-coalesce-{}".format(int(dims[0]*dims[1]*dims[2]/MB), coalesce_reads),  ReadIdxBoxQuery(filename, dims, coalesce_reads=coalesce_reads))
+
 
 	print("all done")
 	sys.exit(0)